@@ -0,0 +1,144 @@
+// Microbenchmark for the book search predicates: the strcmp / stringstream
+// implementation show used before string_match.h, against every kernel set
+// the CPU supports. Each kernel is checked against the reference first.
+//
+// Usage: match_bench [fields] [rounds]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include "../string_match.h"
+
+using namespace std;
+
+const int FIELD_SIZE = 65;
+
+struct Field {
+    char bytes[FIELD_SIZE];
+};
+
+bool referenceFieldEquals(const char* field, const string& value) {
+    return strcmp(field, value.c_str()) == 0;
+}
+
+bool referenceKeywordMatch(const string& keywords, const string& keyword) {
+    stringstream ss(keywords);
+    string k;
+    while (getline(ss, k, '|')) {
+        if (k == keyword) return true;
+    }
+    return false;
+}
+
+string randomWord(mt19937& rng, const vector<string>& vocabulary) {
+    return vocabulary[rng() % vocabulary.size()];
+}
+
+// Fields hold '|'-joined words; bytes after the terminator are left as
+// garbage, like a record whose field was overwritten by a shorter string.
+vector<Field> makeFields(mt19937& rng, const vector<string>& vocabulary, size_t count) {
+    vector<Field> fields(count);
+    for (auto& field : fields) {
+        for (int i = 0; i < FIELD_SIZE; i++) field.bytes[i] = "ab|c"[rng() % 4];
+        string text = randomWord(rng, vocabulary);
+        int segments = rng() % 4;
+        for (int i = 0; i < segments && text.size() < 45; i++) {
+            text += "|" + randomWord(rng, vocabulary);
+        }
+        memcpy(field.bytes, text.c_str(), text.size() + 1);
+    }
+    return fields;
+}
+
+template<typename Predicate>
+double nanosPerField(const vector<Field>& fields, int rounds, Predicate predicate, size_t& matches) {
+    matches = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const auto& field : fields) {
+            matches += predicate(field.bytes);
+        }
+    }
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return elapsed / (double(fields.size()) * rounds);
+}
+
+bool verify(const MatchKernels& kernels, const vector<Field>& fields, const vector<string>& queries) {
+    for (const auto& query : queries) {
+        PaddedKey key(query);
+        for (const auto& field : fields) {
+            if (kernels.fieldEquals(field.bytes, key) != referenceFieldEquals(field.bytes, query) ||
+                kernels.keywordListContains(field.bytes, key) != referenceKeywordMatch(field.bytes, query)) {
+                cerr << kernels.name << " disagrees with reference on field \"" << field.bytes
+                     << "\" and query \"" << query << "\"\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t fieldCount = argc > 1 ? stoul(argv[1]) : 200000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 5;
+
+    mt19937 rng(2024);
+    vector<string> vocabulary;
+    for (int i = 0; i < 200; i++) {
+        string word;
+        int length = 1 + rng() % 14;
+        for (int j = 0; j < length; j++) word += char('a' + rng() % 26);
+        vocabulary.push_back(word);
+    }
+    vector<Field> fields = makeFields(rng, vocabulary, fieldCount);
+    vector<string> queries = {vocabulary[0], vocabulary[1], vocabulary[2], "a", string(60, 'z')};
+
+    vector<const MatchKernels*> candidates = {&scalarKernels()};
+#ifdef BOOKSTORE_HAS_X86_KERNELS
+    if (__builtin_cpu_supports("sse2")) candidates.push_back(&sse2Kernels());
+    if (__builtin_cpu_supports("avx2")) candidates.push_back(&avx2Kernels());
+#endif
+
+    vector<Field> sample(fields.begin(), fields.begin() + min<size_t>(fields.size(), 5000));
+    for (auto kernels : candidates) {
+        if (!verify(*kernels, sample, queries)) return 1;
+    }
+
+    const string& query = vocabulary[0];
+    PaddedKey key(query);
+    size_t matches;
+    cout << fieldCount << " fields x " << rounds << " rounds, selected kernels: "
+         << matchKernels().name << "\n";
+    cout << fixed << setprecision(2);
+
+    double base = nanosPerField(fields, rounds, [&](const char* field) {
+        return referenceFieldEquals(field, query);
+    }, matches);
+    cout << "field equality   strcmp        " << setw(8) << base << " ns/field  (" << matches << " matches)\n";
+    for (auto kernels : candidates) {
+        double time = nanosPerField(fields, rounds, [&](const char* field) {
+            return kernels->fieldEquals(field, key);
+        }, matches);
+        cout << "field equality   " << left << setw(14) << kernels->name << right << setw(8) << time
+             << " ns/field  (" << matches << " matches, " << base / time << "x)\n";
+    }
+
+    base = nanosPerField(fields, rounds, [&](const char* field) {
+        return referenceKeywordMatch(field, query);
+    }, matches);
+    cout << "keyword member   stringstream  " << setw(8) << base << " ns/field  (" << matches << " matches)\n";
+    for (auto kernels : candidates) {
+        double time = nanosPerField(fields, rounds, [&](const char* field) {
+            return kernels->keywordListContains(field, key);
+        }, matches);
+        cout << "keyword member   " << left << setw(14) << kernels->name << right << setw(8) << time
+             << " ns/field  (" << matches << " matches, " << base / time << "x)\n";
+    }
+
+    return 0;
+}
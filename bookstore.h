@@ -0,0 +1,1783 @@
+#ifndef BOOKSTORE_H
+#define BOOKSTORE_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <cstddef>
+#include <cerrno>
+#include "string_match.h"
+
+using namespace std;
+
+// ==================== Data Structures ====================
+
+const int MAX_STRING_LENGTH = 65;
+const int MAX_KEYWORD_LENGTH = 65;
+const int MAX_USERNAME_LENGTH = 35;
+
+struct Account {
+    char userID[32];
+    char password[32];
+    char username[MAX_USERNAME_LENGTH];
+    int privilege;
+    
+    Account() : privilege(0) {
+        memset(userID, 0, sizeof(userID));
+        memset(password, 0, sizeof(password));
+        memset(username, 0, sizeof(username));
+    }
+};
+
+struct Book {
+    char ISBN[24];
+    char name[MAX_STRING_LENGTH];
+    char author[MAX_STRING_LENGTH];
+    char keyword[MAX_STRING_LENGTH];
+    double price;
+    int quantity;
+    
+    Book() : price(0), quantity(0) {
+        memset(ISBN, 0, sizeof(ISBN));
+        memset(name, 0, sizeof(name));
+        memset(author, 0, sizeof(author));
+        memset(keyword, 0, sizeof(keyword));
+    }
+    
+    bool operator<(const Book& other) const {
+        return strcmp(ISBN, other.ISBN) < 0;
+    }
+};
+
+// Refers to a record by slot without an index lookup. The version changes
+// whenever the slot stops holding the same record (rename, delete, move by
+// compaction), so a stale handle is detected instead of being followed.
+struct RecordHandle {
+    int slot;
+    uint64_t version;
+    
+    RecordHandle() : slot(-1), version(0) {}
+    RecordHandle(int slot, uint64_t version) : slot(slot), version(version) {}
+};
+
+struct Transaction {
+    double amount;
+    bool isIncome; // true for buy, false for import
+};
+
+struct LogEntry {
+    char userID[32];
+    char operation[256];
+};
+
+// ==================== Storage Configuration ====================
+
+// Data file limit from the assignment README
+const int MAX_DATA_FILES = 20;
+const long MIN_PAGE_SIZE = 512;
+const long MAX_PAGE_SIZE = 1 << 20;
+
+// Where the data files live and how the book store and ledgers are split.
+// The defaults reproduce the original layout: one accounts.dat, books.dat,
+// transactions.dat and logs.dat in the working directory.
+struct StorageConfig {
+    string dataDir;
+    size_t pageSize;   // stream buffer size for bulk reads
+    int bookShards;    // books.dat, or books.<n>.dat hash-partitioned by ISBN
+    int ledgerShards;  // transactions/logs, records dealt round-robin
+    int maxFiles;
+    
+    StorageConfig() : dataDir("."), pageSize(4096), bookShards(1), ledgerShards(1),
+                      maxFiles(MAX_DATA_FILES) {}
+    
+    string filePath(const string& name) const {
+        return (filesystem::path(dataDir) / name).string();
+    }
+    
+    vector<string> shardPaths(const string& base, int shards) const {
+        vector<string> paths;
+        if (shards == 1) {
+            paths.push_back(filePath(base + ".dat"));
+        } else {
+            for (int i = 0; i < shards; i++) {
+                paths.push_back(filePath(base + "." + to_string(i) + ".dat"));
+            }
+        }
+        return paths;
+    }
+    
+    // accounts.dat and journal.dat, the book shards, and both ledgers
+    int fileCount() const {
+        return 2 + bookShards + 2 * ledgerShards;
+    }
+    
+    // Whether `name` is a data file of `base` in any layout: base.dat or
+    // base.<n>.dat
+    static bool isShardFile(const string& name, const string& base) {
+        if (name == base + ".dat") return true;
+        if (name.size() < base.size() + 6 || name.compare(0, base.size() + 1, base + ".") != 0 ||
+            name.compare(name.size() - 4, 4, ".dat") != 0) {
+            return false;
+        }
+        string number = name.substr(base.size() + 1, name.size() - base.size() - 5);
+        return number.find_first_not_of("0123456789") == string::npos;
+    }
+    
+    // Whether the files of `base` already in dataDir are exactly the ones a
+    // `shards`-way layout uses, or there are none yet. Opening data with more
+    // or fewer shards than it was written with would lose records.
+    bool layoutMatches(const string& base, int shards) const {
+        set<string> expected;
+        for (const auto& path : shardPaths(base, shards)) {
+            expected.insert(filesystem::path(path).filename().string());
+        }
+        size_t present = 0;
+        error_code ec;
+        for (const auto& entry : filesystem::directory_iterator(dataDir, ec)) {
+            string name = entry.path().filename().string();
+            if (!isShardFile(name, base)) continue;
+            if (!expected.count(name)) return false;
+            present++;
+        }
+        return present == 0 || present == expected.size();
+    }
+    
+    // Consumes argv[i] and its value if it is a storage option. Returns false
+    // if it is not one; a malformed value is reported through error.
+    bool parseOption(int argc, char* argv[], int& i, string& error) {
+        string flag = argv[i];
+        if (flag != "--data-dir" && flag != "--page-size" && flag != "--book-shards" &&
+            flag != "--ledger-shards" && flag != "--max-files") {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            error = flag + " needs a value";
+            return true;
+        }
+        string value = argv[++i];
+        if (flag == "--data-dir") {
+            dataDir = value;
+            return true;
+        }
+        long low = flag == "--page-size" ? MIN_PAGE_SIZE : 1;
+        long high = flag == "--page-size" ? MAX_PAGE_SIZE : MAX_DATA_FILES;
+        errno = 0;
+        long number = strtol(value.c_str(), nullptr, 10);
+        if (value.empty() || value.find_first_not_of("0123456789") != string::npos || errno == ERANGE ||
+            number < low || number > high) {
+            error = flag + " needs an integer from " + to_string(low) + " to " + to_string(high);
+        } else if (flag == "--page-size") {
+            pageSize = number;
+        } else if (flag == "--book-shards") {
+            bookShards = number;
+        } else if (flag == "--ledger-shards") {
+            ledgerShards = number;
+        } else {
+            maxFiles = number;
+        }
+        return true;
+    }
+    
+    // Checks the file budget and that existing data was written with the same
+    // shard counts, then creates the data directory.
+    bool prepare(string& error) const {
+        if (maxFiles > MAX_DATA_FILES) {
+            error = "file budget is capped at " + to_string(MAX_DATA_FILES);
+            return false;
+        }
+        if (fileCount() > maxFiles) {
+            error = "layout needs " + to_string(fileCount()) + " files, budget is " + to_string(maxFiles);
+            return false;
+        }
+        if (pageSize < MIN_PAGE_SIZE || pageSize > MAX_PAGE_SIZE) {
+            error = "page size must be between " + to_string(MIN_PAGE_SIZE) + " and " +
+                    to_string(MAX_PAGE_SIZE) + " bytes";
+            return false;
+        }
+        
+        const pair<string, int> layouts[] = {
+            {"books", bookShards}, {"transactions", ledgerShards}, {"logs", ledgerShards}
+        };
+        for (const auto& layout : layouts) {
+            if (!layoutMatches(layout.first, layout.second)) {
+                error = layout.first + " data was written with a different shard count";
+                return false;
+            }
+        }
+        
+        error_code ec;
+        filesystem::create_directories(dataDir, ec);
+        if (ec) {
+            error = "cannot create " + dataDir + ": " + ec.message();
+            return false;
+        }
+        return true;
+    }
+};
+
+// ==================== File Storage System ====================
+
+// Called before every write, clear and truncate of a data file when set.
+// bookstore_replay uses it to end the process at a chosen write; the program
+// itself never sets it.
+inline void (*beforeFileWrite)() = nullptr;
+
+class FileStorage {
+private:
+    string filename;
+    size_t pageSize;
+    
+public:
+    FileStorage(const string& fname, size_t pageSize = 4096) : filename(fname), pageSize(pageSize) {
+        // Initialize file if not exists
+        ifstream test(filename);
+        if (!test) {
+            ofstream create(filename, ios::binary);
+            create.close();
+        }
+        test.close();
+    }
+    
+    template<typename T>
+    void write(const T& data, streampos pos = -1) {
+        if (beforeFileWrite) beforeFileWrite();
+        fstream file(filename, ios::binary | ios::in | ios::out);
+        if (pos >= 0) {
+            file.seekp(pos);
+        } else {
+            file.seekp(0, ios::end);
+        }
+        file.write(reinterpret_cast<const char*>(&data), sizeof(T));
+        file.close();
+    }
+    
+    // Writes `count` consecutive records starting at record position `first`
+    // with a single write call
+    template<typename T>
+    void writeRange(const T* data, size_t count, size_t first) {
+        if (beforeFileWrite) beforeFileWrite();
+        fstream file(filename, ios::binary | ios::in | ios::out);
+        file.seekp((streampos)first * (streampos)sizeof(T));
+        file.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+        file.close();
+    }
+    
+    template<typename T>
+    bool read(T& data, streampos pos) {
+        ifstream file(filename, ios::binary);
+        file.seekg(pos);
+        file.read(reinterpret_cast<char*>(&data), sizeof(T));
+        bool success = file.gcount() == sizeof(T);
+        file.close();
+        return success;
+    }
+    
+    template<typename T>
+    vector<T> readAll() {
+        vector<T> result;
+        vector<char> buffer(pageSize);
+        ifstream file;
+        file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        file.open(filename, ios::binary);
+        T data;
+        while (file.read(reinterpret_cast<char*>(&data), sizeof(T))) {
+            result.push_back(data);
+        }
+        file.close();
+        return result;
+    }
+    
+    // Reads records [first, first + count), stopping early at end of file.
+    template<typename T>
+    vector<T> readRange(size_t first, size_t count) {
+        vector<T> result;
+        result.reserve(count);
+        vector<char> buffer(pageSize);
+        ifstream file;
+        file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        file.open(filename, ios::binary);
+        file.seekg((streampos)first * (streampos)sizeof(T));
+        T data;
+        while (result.size() < count && file.read(reinterpret_cast<char*>(&data), sizeof(T))) {
+            result.push_back(data);
+        }
+        file.close();
+        return result;
+    }
+    
+    void clear() {
+        if (beforeFileWrite) beforeFileWrite();
+        ofstream file(filename, ios::binary | ios::trunc);
+        file.close();
+    }
+    
+    void truncate(size_t bytes) {
+        if (beforeFileWrite) beforeFileWrite();
+        error_code ec;
+        filesystem::resize_file(filename, bytes, ec);
+    }
+    
+    size_t size() {
+        error_code ec;
+        uintmax_t bytes = filesystem::file_size(filename, ec);
+        return ec ? 0 : (size_t)bytes;
+    }
+};
+
+// ==================== Record Store ====================
+
+inline const char* recordKey(const Account& acc) { return acc.userID; }
+inline const char* recordKey(const Book& book) { return book.ISBN; }
+
+struct StoreStats {
+    size_t slots;
+    size_t live;
+    size_t fileBytes;
+    
+    double fragmentation() const {
+        return slots == 0 ? 0.0 : double(slots - live) / slots;
+    }
+};
+
+// FNV-1a with a final avalanche step; places keys on shards
+inline uint64_t hashString(const string& key) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Fixed-size records addressed by slot. Updates are written in place, deletes
+// leave a zeroed tombstone slot that later inserts reuse, and compactStep()
+// moves tail records into holes so the file shrinks back to the live data.
+//
+// Records are hash-partitioned by key over one or more shard files. A slot id
+// interleaves the shards (id = local slot * shard count + shard), so ids and
+// handles stay plain ints across shards.
+template<typename T>
+class RecordStore {
+private:
+    struct Shard {
+        FileStorage file;
+        vector<T> records;         // indexed by local slot; an empty key marks a free slot
+        vector<uint64_t> versions; // per slot, drawn from a counter that never repeats
+        set<int> freeSlots;
+        
+        Shard(const string& path, size_t pageSize) : file(path, pageSize) {}
+    };
+    
+    vector<Shard> shards;
+    map<string, int> index;  // key -> slot id, in key order
+    uint64_t lastVersion;
+    
+    static streampos offset(int local) {
+        return (streampos)local * (streampos)sizeof(T);
+    }
+    
+    int slotId(int shard, int local) const {
+        return local * (int)shards.size() + shard;
+    }
+    
+    Shard& shardOf(int slot) {
+        return shards[slot % shards.size()];
+    }
+    
+    const Shard& shardOf(int slot) const {
+        return shards[slot % shards.size()];
+    }
+    
+    int localOf(int slot) const {
+        return slot / (int)shards.size();
+    }
+    
+    int shardFor(const char* key) const {
+        return shards.size() == 1 ? 0 : hashString(key) % shards.size();
+    }
+    
+    // Tombstones a slot whose key is already out of the index
+    void release(int slot) {
+        Shard& shard = shardOf(slot);
+        int local = localOf(slot);
+        shard.records[local] = T();
+        shard.versions[local] = ++lastVersion;
+        shard.freeSlots.insert(local);
+        update(slot);
+    }
+    
+public:
+    RecordStore(const vector<string>& paths, size_t pageSize) : lastVersion(0) {
+        for (const auto& path : paths) {
+            shards.emplace_back(path, pageSize);
+        }
+        for (int s = 0; s < (int)shards.size(); s++) {
+            Shard& shard = shards[s];
+            shard.records = shard.file.template readAll<T>();
+            shard.versions.resize(shard.records.size());
+            for (int local = 0; local < (int)shard.records.size(); local++) {
+                shard.versions[local] = ++lastVersion;
+                const char* key = recordKey(shard.records[local]);
+                if (key[0] == '\0') {
+                    shard.freeSlots.insert(local);
+                } else if (!index.emplace(key, slotId(s, local)).second) {
+                    // A compaction cut short after copying a tail record into
+                    // a hole leaves the same record in both slots; keep the
+                    // first and free the tail copy
+                    release(slotId(s, local));
+                }
+            }
+        }
+    }
+    
+    int find(const string& key) {
+        auto it = index.find(key);
+        return it == index.end() ? -1 : it->second;
+    }
+    
+    bool contains(const string& key) {
+        return find(key) >= 0;
+    }
+    
+    T& at(int slot) {
+        return shardOf(slot).records[localOf(slot)];
+    }
+    
+    const T& at(int slot) const {
+        return shardOf(slot).records[localOf(slot)];
+    }
+    
+    // Whether the slot id lies inside its shard file
+    bool holds(int slot) const {
+        return slot >= 0 && localOf(slot) < (int)shardOf(slot).records.size();
+    }
+    
+    // Slots over all shards, including free ones (empty key)
+    size_t slotCount() const {
+        size_t total = 0;
+        for (const auto& shard : shards) total += shard.records.size();
+        return total;
+    }
+    
+    // Visits the records at scan positions [begin, end), where positions
+    // number the slots shard by shard. Free slots are included.
+    template<typename Visit>
+    void scanRange(size_t begin, size_t end, Visit visit) const {
+        size_t shardStart = 0;
+        for (const auto& shard : shards) {
+            size_t shardEnd = shardStart + shard.records.size();
+            for (size_t position = max(begin, shardStart); position < min(end, shardEnd); position++) {
+                visit(shard.records[position - shardStart]);
+            }
+            shardStart = shardEnd;
+        }
+    }
+    
+    size_t liveCount() const {
+        return index.size();
+    }
+    
+    const map<string, int>& keys() const {
+        return index;
+    }
+    
+    RecordHandle handle(int slot) const {
+        return RecordHandle(slot, shardOf(slot).versions[localOf(slot)]);
+    }
+    
+    bool isCurrent(const RecordHandle& handle) const {
+        return holds(handle.slot) && shardOf(handle.slot).versions[localOf(handle.slot)] == handle.version;
+    }
+    
+    int insert(const T& record) {
+        int s = shardFor(recordKey(record));
+        Shard& shard = shards[s];
+        int local;
+        if (!shard.freeSlots.empty()) {
+            local = *shard.freeSlots.begin();
+            shard.freeSlots.erase(shard.freeSlots.begin());
+            shard.records[local] = record;
+        } else {
+            local = shard.records.size();
+            shard.records.push_back(record);
+            shard.versions.push_back(++lastVersion);
+        }
+        int slot = slotId(s, local);
+        index[recordKey(record)] = slot;
+        update(slot);
+        return slot;
+    }
+    
+    void update(int slot) {
+        shardOf(slot).file.write(at(slot), offset(localOf(slot)));
+    }
+    
+    // Re-indexes a record whose key was changed through at(slot). The new key
+    // must belong to the same shard (placement(slot, record) == slot).
+    void rekey(int slot, const string& oldKey) {
+        index.erase(oldKey);
+        shardOf(slot).versions[localOf(slot)] = ++lastVersion;
+        index[recordKey(at(slot))] = slot;
+        update(slot);
+    }
+    
+    // Slot a record now at `slot` must occupy: the same one unless its key
+    // belongs to another shard, in which case the slot insert() would pick
+    // there. Moves are journaled by the caller and applied with place().
+    int placement(int slot, const T& record) const {
+        int s = shardFor(recordKey(record));
+        if (s == slot % (int)shards.size()) return slot;
+        const Shard& shard = shards[s];
+        int local = shard.freeSlots.empty() ? (int)shard.records.size() : *shard.freeSlots.begin();
+        return slotId(s, local);
+    }
+    
+    // Writes a record into a slot picked by placement(): a free slot, the
+    // next one past the end of its shard, or one already holding the same
+    // key. Returns false, writing nothing, for any other slot.
+    bool place(int slot, const T& record) {
+        const char* key = recordKey(record);
+        if (slot < 0 || shardFor(key) != slot % (int)shards.size()) return false;
+        Shard& shard = shardOf(slot);
+        int local = localOf(slot);
+        if (local > (int)shard.records.size()) return false;
+        auto it = index.find(key);
+        if (it != index.end() && it->second != slot) return false;
+        if (local < (int)shard.records.size() && !shard.freeSlots.count(local) &&
+            strcmp(recordKey(shard.records[local]), key) != 0) {
+            return false;
+        }
+        
+        if (local == (int)shard.records.size()) {
+            shard.records.push_back(record);
+            shard.versions.push_back(++lastVersion);
+        } else {
+            shard.freeSlots.erase(local);
+            shard.records[local] = record;
+            shard.versions[local] = ++lastVersion;
+        }
+        index[key] = slot;
+        update(slot);
+        return true;
+    }
+    
+    void erase(int slot) {
+        index.erase(recordKey(at(slot)));
+        release(slot);
+    }
+    
+    // Inserts or overwrites many records at once and returns how many were
+    // new. New records are appended to their shard instead of filling free
+    // slots, and each shard is written from its first changed slot to its
+    // end in one sequential write. For offline loading: a crash part way
+    // through leaves some records written and others not.
+    size_t bulkLoad(const vector<T>& batch) {
+        vector<size_t> firstDirty(shards.size(), SIZE_MAX);
+        size_t added = 0;
+        for (const T& record : batch) {
+            const char* key = recordKey(record);
+            auto it = index.lower_bound(key);
+            int slot;
+            if (it != index.end() && it->first == key) {
+                slot = it->second;
+                at(slot) = record;
+                shardOf(slot).versions[localOf(slot)] = ++lastVersion;
+            } else {
+                int s = shardFor(key);
+                slot = slotId(s, shards[s].records.size());
+                shards[s].records.push_back(record);
+                shards[s].versions.push_back(++lastVersion);
+                index.emplace_hint(it, key, slot);
+                added++;
+            }
+            size_t& first = firstDirty[slot % shards.size()];
+            first = min(first, (size_t)localOf(slot));
+        }
+        
+        for (size_t s = 0; s < shards.size(); s++) {
+            Shard& shard = shards[s];
+            if (firstDirty[s] == SIZE_MAX) continue;
+            shard.file.writeRange(shard.records.data() + firstDirty[s],
+                                  shard.records.size() - firstDirty[s], firstDirty[s]);
+        }
+        return added;
+    }
+    
+    // Reclaims at most `budget` free slots; returns how many were reclaimed.
+    size_t compactStep(size_t budget) {
+        size_t reclaimed = 0;
+        for (int s = 0; s < (int)shards.size(); s++) {
+            Shard& shard = shards[s];
+            size_t oldSlots = shard.records.size();
+            while (reclaimed < budget && !shard.freeSlots.empty()) {
+                int last = shard.records.size() - 1;
+                if (shard.freeSlots.count(last)) {
+                    shard.freeSlots.erase(last);
+                } else {
+                    int hole = *shard.freeSlots.begin();
+                    shard.freeSlots.erase(shard.freeSlots.begin());
+                    shard.records[hole] = shard.records[last];
+                    shard.versions[hole] = ++lastVersion;
+                    index[recordKey(shard.records[hole])] = slotId(s, hole);
+                    update(slotId(s, hole));
+                }
+                shard.records.pop_back();
+                shard.versions.pop_back();
+                reclaimed++;
+            }
+            if (shard.records.size() != oldSlots) {
+                shard.file.truncate(shard.records.size() * sizeof(T));
+            }
+        }
+        return reclaimed;
+    }
+    
+    StoreStats stats() {
+        StoreStats result = {0, index.size(), 0};
+        for (auto& shard : shards) {
+            result.slots += shard.records.size();
+            result.fileBytes += shard.file.size();
+        }
+        return result;
+    }
+};
+
+// ==================== Ledger File ====================
+
+// Append-only record sequence spread round-robin over its shard files:
+// record i lives in shard i % shards at local position i / shards.
+template<typename T>
+class LedgerFile {
+private:
+    vector<FileStorage> files;
+    size_t count;
+    
+public:
+    // The ledger ends at the first record missing from its shard, so a
+    // write lost in a crash is overwritten rather than left as a hole
+    LedgerFile(const vector<string>& paths, size_t pageSize) : count(SIZE_MAX) {
+        for (size_t s = 0; s < paths.size(); s++) {
+            files.emplace_back(paths[s], pageSize);
+            count = min(count, files.back().size() / sizeof(T) * paths.size() + s);
+        }
+    }
+    
+    size_t size() const {
+        return count;
+    }
+    
+    // Writes record `index` at its fixed position; rewriting it is harmless
+    void write(size_t index, const T& record) {
+        size_t shards = files.size();
+        files[index % shards].write(record, (streampos)(index / shards) * (streampos)sizeof(T));
+        count = max(count, index + 1);
+    }
+    
+    // Reads records [first, first + length), clipped to the ledger size
+    vector<T> readRange(size_t first, size_t length) {
+        size_t shards = files.size();
+        size_t end = min(count, first + length);
+        if (first >= end) return vector<T>();
+        
+        vector<vector<T>> parts(shards);
+        for (size_t s = 0; s < shards; s++) {
+            size_t localBegin = (first + shards - 1 - s) / shards;
+            size_t localEnd = (end + shards - 1 - s) / shards;
+            parts[s] = files[s].template readRange<T>(localBegin, localEnd - localBegin);
+        }
+        
+        vector<T> result;
+        result.reserve(end - first);
+        for (size_t i = first; i < end; i++) {
+            size_t s = i % shards;
+            size_t localBegin = (first + shards - 1 - s) / shards;
+            size_t local = i / shards - localBegin;
+            if (local >= parts[s].size()) break; // torn tail after a crash
+            result.push_back(parts[s][local]);
+        }
+        return result;
+    }
+};
+
+// ==================== Parallel Scan ====================
+
+// Inputs smaller than this are scanned inline; thread start-up would dominate
+const size_t PARALLEL_SCAN_MIN_RECORDS = 1 << 16;
+const size_t PARALLEL_SCAN_CHUNK = 4096;
+
+// Splits [0, n) into fixed-size chunks and calls body(chunk, begin, end) for
+// each. Workers pull the next chunk from a shared counter, so a slow chunk
+// never holds up the others. Results keyed by chunk index merge
+// deterministically whatever the number of threads.
+template<typename Body>
+void parallelChunks(size_t n, Body body) {
+    size_t chunks = (n + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK;
+    size_t workers = min<size_t>(thread::hardware_concurrency(), chunks);
+    
+    auto runChunk = [&](size_t chunk) {
+        size_t begin = chunk * PARALLEL_SCAN_CHUNK;
+        body(chunk, begin, min(n, begin + PARALLEL_SCAN_CHUNK));
+    };
+    
+    if (n < PARALLEL_SCAN_MIN_RECORDS || workers <= 1) {
+        for (size_t chunk = 0; chunk < chunks; chunk++) runChunk(chunk);
+        return;
+    }
+    
+    atomic<size_t> next(0);
+    vector<thread> pool;
+    for (size_t i = 0; i < workers; i++) {
+        pool.emplace_back([&]() {
+            for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+                runChunk(chunk);
+            }
+        });
+    }
+    for (auto& worker : pool) worker.join();
+}
+
+// ==================== Account Management ====================
+
+class AccountManager {
+private:
+    RecordStore<Account> accounts;
+    struct LoginFrame {
+        string userID;
+        string selectedISBN;
+        RecordHandle selectedBook; // cached location of selectedISBN
+    };
+    
+    vector<LoginFrame> loginStack;
+    
+public:
+    explicit AccountManager(const StorageConfig& config)
+        : accounts({config.filePath("accounts.dat")}, config.pageSize) {
+        // Create root account if not exists
+        if (!accounts.contains("root")) {
+            Account root;
+            strcpy(root.userID, "root");
+            strcpy(root.password, "sjtu");
+            strcpy(root.username, "root");
+            root.privilege = 7;
+            accounts.insert(root);
+        }
+    }
+    
+    int getCurrentPrivilege() {
+        if (loginStack.empty()) return 0;
+        return accounts.at(accounts.find(loginStack.back().userID)).privilege;
+    }
+    
+    string getCurrentUser() {
+        if (loginStack.empty()) return "";
+        return loginStack.back().userID;
+    }
+    
+    string getSelectedBook() {
+        if (loginStack.empty()) return "";
+        return loginStack.back().selectedISBN;
+    }
+    
+    RecordHandle getSelectedHandle() {
+        if (loginStack.empty()) return RecordHandle();
+        return loginStack.back().selectedBook;
+    }
+    
+    void setSelectedBook(const string& isbn, const RecordHandle& handle) {
+        if (!loginStack.empty()) {
+            loginStack.back().selectedISBN = isbn;
+            loginStack.back().selectedBook = handle;
+        }
+    }
+    
+    bool login(const string& userID, const string& password) {
+        int slot = accounts.find(userID);
+        if (slot < 0) return false;
+        
+        Account& acc = accounts.at(slot);
+        if (!password.empty() && password != acc.password) {
+            // Check if current privilege is higher
+            if (getCurrentPrivilege() <= acc.privilege) return false;
+        }
+        
+        loginStack.push_back({userID, "", RecordHandle()});
+        return true;
+    }
+    
+    bool logout() {
+        if (loginStack.empty()) return false;
+        loginStack.pop_back();
+        return true;
+    }
+    
+    bool registerAccount(const string& userID, const string& password, const string& username) {
+        if (accounts.contains(userID)) return false;
+        
+        Account acc;
+        strcpy(acc.userID, userID.c_str());
+        strcpy(acc.password, password.c_str());
+        strcpy(acc.username, username.c_str());
+        acc.privilege = 1;
+        
+        accounts.insert(acc);
+        return true;
+    }
+    
+    bool changePassword(const string& userID, const string& currentPassword, const string& newPassword) {
+        int slot = accounts.find(userID);
+        if (slot < 0) return false;
+        
+        Account& acc = accounts.at(slot);
+        
+        // If currentPassword is provided, it must match (unless privilege 7 can skip verification)
+        if (!currentPassword.empty()) {
+            if (currentPassword != acc.password) return false;
+        } else {
+            // If currentPassword is empty, only privilege 7 can proceed
+            if (getCurrentPrivilege() != 7) return false;
+        }
+        
+        strcpy(acc.password, newPassword.c_str());
+        accounts.update(slot);
+        return true;
+    }
+    
+    bool addAccount(const string& userID, const string& password, int privilege, const string& username) {
+        if (accounts.contains(userID)) return false;
+        if (privilege >= getCurrentPrivilege()) return false;
+        
+        Account acc;
+        strcpy(acc.userID, userID.c_str());
+        strcpy(acc.password, password.c_str());
+        strcpy(acc.username, username.c_str());
+        acc.privilege = privilege;
+        
+        accounts.insert(acc);
+        return true;
+    }
+    
+    bool deleteAccount(const string& userID) {
+        int slot = accounts.find(userID);
+        if (slot < 0) return false;
+        
+        // Check if account is logged in
+        for (const auto& login : loginStack) {
+            if (login.userID == userID) return false;
+        }
+        
+        accounts.erase(slot);
+        return true;
+    }
+    
+    size_t compact(size_t budget) {
+        return accounts.compactStep(budget);
+    }
+    
+    StoreStats storageStats() {
+        return accounts.stats();
+    }
+};
+
+// ==================== Book Management ====================
+
+class BookManager {
+private:
+    RecordStore<Book> books;
+    
+    // Search predicate with the query padded once for the match kernels
+    struct BookFilter {
+        enum Field { ALL, NAME, AUTHOR, KEYWORD, NONE } field;
+        PaddedKey key;
+        const MatchKernels& kernels;
+        
+        BookFilter(const string& type, const string& value)
+            : key(value), kernels(matchKernels()) {
+            if (type.empty()) field = ALL;
+            else if (type == "name") field = NAME;
+            else if (type == "author") field = AUTHOR;
+            else if (type == "keyword") field = KEYWORD;
+            else field = NONE;
+        }
+        
+        bool operator()(const Book& book) const {
+            switch (field) {
+                case ALL: return true;
+                case NAME: return kernels.fieldEquals(book.name, key);
+                case AUTHOR: return kernels.fieldEquals(book.author, key);
+                case KEYWORD: return kernels.keywordListContains(book.keyword, key);
+                default: return false;
+            }
+        }
+    };
+    
+    static_assert(MAX_STRING_LENGTH >= (int)MATCH_WIDTH, "book fields must cover the match window");
+    
+public:
+    explicit BookManager(const StorageConfig& config)
+        : books(config.shardPaths("books", config.bookShards), config.pageSize) {}
+    
+    // Follows a selected book's cached handle, falling back to an index
+    // lookup (and refreshing the handle) once it has gone stale
+    int resolve(const string& isbn, RecordHandle& handle) {
+        if (books.isCurrent(handle)) return handle.slot;
+        int slot = books.find(isbn);
+        handle = slot < 0 ? RecordHandle() : books.handle(slot);
+        return slot;
+    }
+    
+    RecordHandle selectBook(const string& isbn) {
+        int slot = books.find(isbn);
+        if (slot < 0) {
+            Book book;
+            strcpy(book.ISBN, isbn.c_str());
+            slot = books.insert(book);
+        }
+        return books.handle(slot);
+    }
+    
+    // Checks a modify and fills in the selected book as it will be after it.
+    // Returns the book's slot, or -1 if the modify must fail.
+    int prepareModify(const string& isbn, RecordHandle& handle, const string& newISBN, const string& name, 
+                      const string& author, const string& keyword, double price, Book& after) {
+        int slot = resolve(isbn, handle);
+        if (slot < 0) return -1;
+        
+        if (!newISBN.empty()) {
+            if (newISBN == isbn) return -1;
+            if (books.contains(newISBN)) return -1;
+        }
+        
+        after = books.at(slot);
+        
+        if (!newISBN.empty()) strcpy(after.ISBN, newISBN.c_str());
+        if (!name.empty()) strcpy(after.name, name.c_str());
+        if (!author.empty()) strcpy(after.author, author.c_str());
+        if (!keyword.empty()) strcpy(after.keyword, keyword.c_str());
+        if (price >= 0) after.price = price;
+        return slot;
+    }
+    
+    // Slot the modified book belongs in; differs from `slot` when a new ISBN
+    // hashes to another shard, and the move must then go through the journal
+    int targetSlot(int slot, const Book& after) const {
+        return books.placement(slot, after);
+    }
+    
+    // Installs a modified book that stays in its slot: one in-place write
+    RecordHandle applyModify(int slot, const string& isbn, const Book& after) {
+        books.at(slot) = after;
+        if (isbn != after.ISBN) books.rekey(slot, isbn);
+        else books.update(slot);
+        return books.handle(slot);
+    }
+    
+    // Installs a book moved to slot `to` and frees `from`, which held it as
+    // `fromISBN`. Halves already done are accepted, which journal recovery
+    // relies on; anything else fails before either slot is written.
+    bool applyMove(int from, const string& fromISBN, int to, const Book& book) {
+        if (!books.holds(from)) return false;
+        string current = books.at(from).ISBN;
+        if (!current.empty() && current != fromISBN) return false;
+        
+        if (!books.place(to, book)) return false;
+        if (!current.empty()) books.erase(from);
+        return true;
+    }
+    
+    RecordHandle handleOf(int slot) const {
+        return books.handle(slot);
+    }
+    
+    // Checks an import and fills in the selected book as it will be after it.
+    // Returns the book's slot, or -1 if the import must fail.
+    int prepareImport(const string& isbn, RecordHandle& handle, int quantity, Book& after) {
+        int slot = resolve(isbn, handle);
+        if (slot < 0) return -1;
+        
+        after = books.at(slot);
+        after.quantity += quantity;
+        return slot;
+    }
+    
+    // Same as prepareImport for a purchase, also computing its cost
+    int prepareBuy(const string& isbn, int quantity, Book& after, double& totalCost) {
+        int slot = books.find(isbn);
+        if (slot < 0) return -1;
+        
+        after = books.at(slot);
+        if (after.quantity < quantity) return -1;
+        
+        totalCost = after.price * quantity;
+        after.quantity -= quantity;
+        return slot;
+    }
+    
+    // Installs a book image from prepareBuy/prepareImport. Writing the same
+    // image twice is harmless, which journal recovery relies on.
+    bool applyBook(int slot, const Book& book) {
+        if (!books.holds(slot)) return false;
+        if (strcmp(books.at(slot).ISBN, book.ISBN) != 0) return false;
+        
+        books.at(slot) = book;
+        books.update(slot);
+        return true;
+    }
+    
+    vector<Book> showBooks(const string& type, const string& value) {
+        vector<Book> result;
+        
+        if (type == "ISBN") {
+            int slot = books.find(value);
+            if (slot >= 0) result.push_back(books.at(slot));
+            return result;
+        }
+        
+        BookFilter matchBook(type, value);
+        
+        // Small stores walk the index, which is already in ISBN order
+        if (books.liveCount() < PARALLEL_SCAN_MIN_RECORDS) {
+            for (const auto& pair : books.keys()) {
+                const Book& book = books.at(pair.second);
+                if (matchBook(book)) result.push_back(book);
+            }
+            return result;
+        }
+        
+        // Large stores scan slot ranges of all shards in parallel, sort each range's matches
+        // and k-way merge the ranges by ISBN
+        vector<vector<Book>> runs((books.slotCount() + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK);
+        parallelChunks(books.slotCount(), [&](size_t chunk, size_t begin, size_t end) {
+            vector<Book>& run = runs[chunk];
+            books.scanRange(begin, end, [&](const Book& book) {
+                if (book.ISBN[0] != '\0' && matchBook(book)) run.push_back(book);
+            });
+            sort(run.begin(), run.end());
+        });
+        
+        typedef pair<size_t, size_t> Cursor; // (run, position)
+        auto later = [&](const Cursor& a, const Cursor& b) {
+            return runs[b.first][b.second] < runs[a.first][a.second];
+        };
+        priority_queue<Cursor, vector<Cursor>, decltype(later)> heads(later);
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (!runs[i].empty()) heads.push({i, 0});
+        }
+        while (!heads.empty()) {
+            Cursor cursor = heads.top();
+            heads.pop();
+            result.push_back(runs[cursor.first][cursor.second]);
+            if (++cursor.second < runs[cursor.first].size()) heads.push(cursor);
+        }
+        return result;
+    }
+    
+    size_t compact(size_t budget) {
+        return books.compactStep(budget);
+    }
+    
+    StoreStats storageStats() {
+        return books.stats();
+    }
+};
+
+// ==================== Log Management ====================
+
+class LogManager {
+private:
+    LedgerFile<Transaction> transactionFile;
+    LedgerFile<LogEntry> logFile;
+    
+public:
+    explicit LogManager(const StorageConfig& config)
+        : transactionFile(config.shardPaths("transactions", config.ledgerShards), config.pageSize),
+          logFile(config.shardPaths("logs", config.ledgerShards), config.pageSize) {}
+    
+    size_t transactionCount() const {
+        return transactionFile.size();
+    }
+    
+    // Writes the ledger record at a fixed position; rewriting it is harmless
+    void writeTransaction(size_t index, const Transaction& t) {
+        transactionFile.write(index, t);
+    }
+    
+    void recordLog(const string& userID, const string& operation) {
+        LogEntry entry;
+        strcpy(entry.userID, userID.c_str());
+        strcpy(entry.operation, operation.c_str());
+        logFile.write(logFile.size(), entry);
+    }
+    
+    bool showFinance(int count, double& income, double& expenditure) {
+        if (count == 0) {
+            income = expenditure = 0;
+            return true;
+        }
+        
+        size_t total = transactionFile.size();
+        if (count > 0 && (size_t)count > total) return false;
+        
+        // Only the requested tail of the ledger is read
+        size_t first = (count > 0) ? total - count : 0;
+        vector<Transaction> transactions = transactionFile.readRange(first, total - first);
+        income = expenditure = 0;
+        
+        for (size_t i = 0; i < transactions.size(); i++) {
+            if (transactions[i].isIncome) {
+                income += transactions[i].amount;
+            } else {
+                expenditure += transactions[i].amount;
+            }
+        }
+        
+        return true;
+    }
+    
+    string generateFinanceReport() {
+        vector<Transaction> transactions = transactionFile.readRange(0, transactionFile.size());
+        stringstream ss;
+        ss << "=== Finance Report ===\n";
+        ss << "Total Transactions: " << transactions.size() << "\n";
+        
+        double income = 0, expenditure = 0;
+        for (const auto& t : transactions) {
+            if (t.isIncome) income += t.amount;
+            else expenditure += t.amount;
+        }
+        
+        ss << fixed << setprecision(2);
+        ss << "Total Income: " << income << "\n";
+        ss << "Total Expenditure: " << expenditure << "\n";
+        ss << "Net Profit: " << (income - expenditure) << "\n";
+        
+        return ss.str();
+    }
+    
+    string generateEmployeeReport() {
+        vector<LogEntry> logs = logFile.readRange(0, logFile.size());
+        
+        vector<map<string, int>> partialOps((logs.size() + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK);
+        parallelChunks(logs.size(), [&](size_t chunk, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                partialOps[chunk][logs[i].userID]++;
+            }
+        });
+        map<string, int> userOps;
+        for (const auto& partial : partialOps) {
+            for (const auto& pair : partial) {
+                userOps[pair.first] += pair.second;
+            }
+        }
+        
+        stringstream ss;
+        ss << "=== Employee Report ===\n";
+        for (const auto& pair : userOps) {
+            ss << "User: " << pair.first << ", Operations: " << pair.second << "\n";
+        }
+        
+        return ss.str();
+    }
+    
+    string generateLog() {
+        vector<LogEntry> logs = logFile.readRange(0, logFile.size());
+        
+        stringstream ss;
+        ss << "=== System Log ===\n";
+        ss << "Total Log Entries: " << logs.size() << "\n";
+        
+        vector<string> sections((logs.size() + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK);
+        parallelChunks(logs.size(), [&](size_t chunk, size_t begin, size_t end) {
+            string& section = sections[chunk];
+            for (size_t i = begin; i < end; i++) {
+                section += "[";
+                section += logs[i].userID;
+                section += "] ";
+                section += logs[i].operation;
+                section += "\n";
+            }
+        });
+        for (const auto& section : sections) {
+            ss << section;
+        }
+        
+        return ss.str();
+    }
+};
+
+// ==================== Transaction Journal ====================
+
+// One buy or import (the book record after the change and the ledger
+// entry) or one cross-shard rename (the book at its new slot and the slot
+// it leaves)
+struct JournalRecord {
+    uint32_t magic;
+    int bookSlot;
+    Book book;
+    int releasedSlot;          // -1 unless the record is a rename
+    char releasedISBN[24];
+    uint64_t transactionIndex;
+    Transaction transaction;
+    uint64_t checksum;
+};
+
+// Makes the two halves of a buy/import (book update and ledger append) or of
+// a cross-shard rename (new slot and old slot) atomic. A commit writes both
+// halves as a single journal record, applies them in place, then empties
+// the journal. A complete record found at startup is applied again; both
+// halves are absolute images at fixed positions, so replaying a record that
+// was already (partly) applied is harmless. A torn record fails its checksum
+// and is dropped, as if the command never ran.
+class TransactionManager {
+private:
+    static const uint32_t JOURNAL_MAGIC = 0x424b4a32; // "BKJ2"
+    
+    FileStorage journalFile;
+    
+    static uint64_t checksum(const JournalRecord& record) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+        uint64_t h = 1469598103934665603ULL;
+        for (size_t i = 0; i < offsetof(JournalRecord, checksum); i++) {
+            h ^= bytes[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+    
+    static JournalRecord emptyRecord() {
+        JournalRecord record;
+        memset(static_cast<void*>(&record), 0, sizeof(record));
+        record.magic = JOURNAL_MAGIC;
+        record.releasedSlot = -1;
+        return record;
+    }
+    
+    bool write(JournalRecord& record, BookManager& bookMgr, LogManager& logMgr) {
+        record.checksum = checksum(record);
+        journalFile.write(record, 0);
+        bool applied = apply(record, bookMgr, logMgr);
+        journalFile.clear();
+        return applied;
+    }
+    
+    // Applies both halves, or neither if the record does not fit the files.
+    // For a buy/import the slot must still hold the book and the ledger entry
+    // must extend the ledger without a gap. For a rename (releasedSlot >= 0)
+    // applyMove checks that the old slot still holds releasedISBN or is
+    // already empty, and that place() accepts the new slot. All checks run
+    // before either half is written.
+    bool apply(const JournalRecord& record, BookManager& bookMgr, LogManager& logMgr) {
+        if (record.releasedSlot >= 0) {
+            return bookMgr.applyMove(record.releasedSlot, record.releasedISBN, record.bookSlot, record.book);
+        }
+        if (record.transactionIndex > logMgr.transactionCount()) return false;
+        if (!bookMgr.applyBook(record.bookSlot, record.book)) return false;
+        logMgr.writeTransaction(record.transactionIndex, record.transaction);
+        return true;
+    }
+    
+public:
+    explicit TransactionManager(const StorageConfig& config)
+        : journalFile(config.filePath("journal.dat")) {}
+    
+    void recover(BookManager& bookMgr, LogManager& logMgr) {
+        JournalRecord record;
+        if (journalFile.read(record, 0) && record.magic == JOURNAL_MAGIC &&
+            record.checksum == checksum(record)) {
+            apply(record, bookMgr, logMgr);
+        }
+        if (journalFile.size() > 0) journalFile.clear();
+    }
+    
+    bool commit(int bookSlot, const Book& book, double amount, bool isIncome,
+                BookManager& bookMgr, LogManager& logMgr) {
+        JournalRecord record = emptyRecord();
+        record.bookSlot = bookSlot;
+        record.book = book;
+        record.transactionIndex = logMgr.transactionCount();
+        record.transaction.amount = amount;
+        record.transaction.isIncome = isIncome;
+        return write(record, bookMgr, logMgr);
+    }
+    
+    // Moves a renamed book from `fromSlot` to `toSlot` in another shard
+    bool commitMove(int fromSlot, const string& fromISBN, int toSlot, const Book& book,
+                    BookManager& bookMgr, LogManager& logMgr) {
+        JournalRecord record = emptyRecord();
+        record.bookSlot = toSlot;
+        record.book = book;
+        record.releasedSlot = fromSlot;
+        strcpy(record.releasedISBN, fromISBN.c_str());
+        return write(record, bookMgr, logMgr);
+    }
+};
+
+// ==================== Input Validation ====================
+
+inline bool isValidUserID(const string& str) {
+    if (str.empty() || str.length() > 30) return false;
+    for (char c : str) {
+        if (!isalnum(c) && c != '_') return false;
+    }
+    return true;
+}
+
+inline bool isValidISBN(const string& str) {
+    return !str.empty() && str.length() <= 20;
+}
+
+inline bool isValidBookString(const string& str) {
+    return !str.empty() && str.length() <= 60;
+}
+
+inline bool isValidKeyword(const string& str) {
+    if (str.empty() || str.length() > 60) return false;
+    set<string> keywords;
+    stringstream ss(str);
+    string k;
+    while (getline(ss, k, '|')) {
+        if (k.empty()) return false;
+        if (keywords.count(k)) return false;
+        keywords.insert(k);
+    }
+    return true;
+}
+
+inline bool safeStoi(const string& str, int& result) {
+    if (str.empty()) return false;
+    try {
+        size_t pos;
+        result = stoi(str, &pos);
+        if (pos != str.length()) return false;
+        // Check for negative in contexts where it shouldn't be
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+inline bool safeStod(const string& str, double& result) {
+    if (str.empty()) return false;
+    try {
+        size_t pos;
+        result = stod(str, &pos);
+        if (pos != str.length()) return false;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+inline bool isValidPrice(const string& str) {
+    if (str.empty()) return false;
+    int dotCount = 0;
+    for (size_t i = 0; i < str.length(); i++) {
+        char c = str[i];
+        if (c == '.') {
+            dotCount++;
+            if (dotCount > 1) return false;
+        } else if (!isdigit(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool isValidInteger(const string& str) {
+    if (str.empty()) return false;
+    for (char c : str) {
+        if (!isdigit(c)) return false;
+    }
+    return true;
+}
+
+// ==================== Main Program ====================
+
+class BookstoreSystem {
+private:
+    AccountManager accountMgr;
+    BookManager bookMgr;
+    LogManager logMgr;
+    TransactionManager txnMgr;
+    ostream& out;
+    bool quitRequested;
+    
+    // Free slots reclaimed per store between two commands
+    static const size_t COMPACTION_BUDGET = 8;
+    
+    string formatStoreStats(const string& name, const StoreStats& stats) {
+        stringstream ss;
+        ss << name << ": " << stats.live << " live / " << stats.slots << " slots, "
+           << stats.fileBytes << " bytes, " << fixed << setprecision(1)
+           << stats.fragmentation() * 100 << "% fragmented\n";
+        return ss.str();
+    }
+    
+    string generateStorageReport() {
+        stringstream ss;
+        ss << "=== Storage ===\n";
+        ss << formatStoreStats("accounts", accountMgr.storageStats());
+        ss << formatStoreStats("books", bookMgr.storageStats());
+        return ss.str();
+    }
+    
+    vector<string> tokenize(const string& line) {
+        vector<string> tokens;
+        string token;
+        bool inQuote = false;
+        
+        for (size_t i = 0; i < line.length(); i++) {
+            char c = line[i];
+            
+            if (c == '"') {
+                token += c;
+                inQuote = !inQuote;
+            } else if (c == ' ' && !inQuote) {
+                if (!token.empty()) {
+                    tokens.push_back(token);
+                    token.clear();
+                }
+            } else {
+                token += c;
+            }
+        }
+        
+        if (!token.empty()) {
+            tokens.push_back(token);
+        }
+        
+        return tokens;
+    }
+    
+    string extractQuoted(const string& str) {
+        size_t start = str.find('"');
+        size_t end = str.rfind('"');
+        if (start != string::npos && end != string::npos && start < end) {
+            return str.substr(start + 1, end - start - 1);
+        }
+        return "";
+    }
+    
+    string extractValue(const string& str) {
+        size_t pos = str.find('=');
+        if (pos != string::npos) {
+            return str.substr(pos + 1);
+        }
+        return "";
+    }
+    
+public:
+    explicit BookstoreSystem(const StorageConfig& config = StorageConfig(), ostream& out = cout)
+        : accountMgr(config), bookMgr(config), logMgr(config), txnMgr(config),
+          out(out), quitRequested(false) {
+        txnMgr.recover(bookMgr, logMgr);
+    }
+    
+    void run() {
+        string line;
+        while (getline(cin, line)) {
+            if (!execute(line)) break;
+            maintain();
+        }
+    }
+    
+    // Runs one input line; returns false once quit or exit has been read.
+    bool execute(string line) {
+        // Trim whitespace
+        size_t start = line.find_first_not_of(" \t\r\n");
+        size_t end = line.find_last_not_of(" \t\r\n");
+        
+        if (start == string::npos) return true; // Empty line
+        
+        line = line.substr(start, end - start + 1);
+        
+        if (!processCommand(line)) {
+            out << "Invalid\n";
+        }
+        return !quitRequested;
+    }
+    
+    // Bounded background work, run between two commands
+    void maintain() {
+        accountMgr.compact(COMPACTION_BUDGET);
+        bookMgr.compact(COMPACTION_BUDGET);
+    }
+    
+    bool processCommand(const string& line) {
+        vector<string> tokens = tokenize(line);
+        if (tokens.empty()) return true;
+        
+        string cmd = tokens[0];
+        
+        // Log command
+        if (accountMgr.getCurrentPrivilege() > 0) {
+            logMgr.recordLog(accountMgr.getCurrentUser(), line);
+        }
+        
+        if (cmd == "quit" || cmd == "exit") {
+            quitRequested = true;
+            return true;
+        }
+        else if (cmd == "su") {
+            if (tokens.size() < 2 || tokens.size() > 3) return false;
+            string userID = tokens[1];
+            string password = tokens.size() == 3 ? tokens[2] : "";
+            if (!isValidUserID(userID)) return false;
+            return accountMgr.login(userID, password);
+        }
+        else if (cmd == "logout") {
+            if (accountMgr.getCurrentPrivilege() < 1) return false;
+            return accountMgr.logout();
+        }
+        else if (cmd == "register") {
+            if (tokens.size() != 4) return false;
+            string userID = tokens[1];
+            string password = tokens[2];
+            string username = tokens[3];
+            if (!isValidUserID(userID) || !isValidUserID(password)) return false;
+            return accountMgr.registerAccount(userID, password, username);
+        }
+        else if (cmd == "passwd") {
+            if (accountMgr.getCurrentPrivilege() < 1) return false;
+            if (tokens.size() < 3 || tokens.size() > 4) return false;
+            string userID = tokens[1];
+            string currentPassword = tokens.size() == 4 ? tokens[2] : "";
+            string newPassword = tokens.size() == 4 ? tokens[3] : tokens[2];
+            if (!isValidUserID(userID) || !isValidUserID(newPassword)) return false;
+            if (tokens.size() == 4 && !isValidUserID(currentPassword)) return false;
+            return accountMgr.changePassword(userID, currentPassword, newPassword);
+        }
+        else if (cmd == "useradd") {
+            if (accountMgr.getCurrentPrivilege() < 3) return false;
+            if (tokens.size() != 5) return false;
+            string userID = tokens[1];
+            string password = tokens[2];
+            if (!isValidInteger(tokens[3])) return false;
+            int privilege;
+            if (!safeStoi(tokens[3], privilege)) return false;
+            string username = tokens[4];
+            if (!isValidUserID(userID) || !isValidUserID(password)) return false;
+            if (privilege != 1 && privilege != 3 && privilege != 7) return false;
+            return accountMgr.addAccount(userID, password, privilege, username);
+        }
+        else if (cmd == "delete") {
+            if (accountMgr.getCurrentPrivilege() < 7) return false;
+            if (tokens.size() != 2) return false;
+            string userID = tokens[1];
+            return accountMgr.deleteAccount(userID);
+        }
+        else if (cmd == "show") {
+            if (accountMgr.getCurrentPrivilege() < 1) return false;
+            
+            if (tokens.size() == 1) {
+                vector<Book> books = bookMgr.showBooks("", "");
+                if (books.empty()) out << "\n";
+                for (const auto& book : books) {
+                    out << book.ISBN << "\t" << book.name << "\t" << book.author 
+                         << "\t" << book.keyword << "\t" << fixed << setprecision(2) 
+                         << book.price << "\t" << book.quantity << "\n";
+                }
+                return true;
+            }
+            else if (tokens[1] == "finance") {
+                if (accountMgr.getCurrentPrivilege() < 7) return false;
+                int count = -1;
+                if (tokens.size() == 3) {
+                    if (!isValidInteger(tokens[2])) return false;
+                    if (!safeStoi(tokens[2], count)) return false;
+                }
+                double income, expenditure;
+                if (!logMgr.showFinance(count, income, expenditure)) return false;
+                if (count == 0) {
+                    out << "\n";
+                } else {
+                    out << "+ " << fixed << setprecision(2) << income 
+                         << " - " << expenditure << "\n";
+                }
+                return true;
+            }
+            else {
+                string param = tokens[1];
+                string type, value;
+                
+                if (param.substr(0, 6) == "-ISBN=") {
+                    type = "ISBN";
+                    value = param.substr(6);
+                    if (!isValidISBN(value)) return false;
+                } else if (param.substr(0, 6) == "-name=") {
+                    type = "name";
+                    value = extractQuoted(param);
+                    if (!isValidBookString(value)) return false;
+                } else if (param.substr(0, 8) == "-author=") {
+                    type = "author";
+                    value = extractQuoted(param);
+                    if (!isValidBookString(value)) return false;
+                } else if (param.substr(0, 9) == "-keyword=") {
+                    type = "keyword";
+                    value = extractQuoted(param);
+                    if (value.empty() || value.find('|') != string::npos) return false;
+                } else {
+                    return false;
+                }
+                
+                vector<Book> books = bookMgr.showBooks(type, value);
+                if (books.empty()) out << "\n";
+                for (const auto& book : books) {
+                    out << book.ISBN << "\t" << book.name << "\t" << book.author 
+                         << "\t" << book.keyword << "\t" << fixed << setprecision(2) 
+                         << book.price << "\t" << book.quantity << "\n";
+                }
+                return true;
+            }
+        }
+        else if (cmd == "buy") {
+            if (accountMgr.getCurrentPrivilege() < 1) return false;
+            if (tokens.size() != 3) return false;
+            string isbn = tokens[1];
+            if (!isValidISBN(isbn)) return false;
+            if (!isValidInteger(tokens[2])) return false;
+            int quantity;
+            if (!safeStoi(tokens[2], quantity)) return false;
+            if (quantity <= 0) return false;
+            
+            double totalCost;
+            Book after;
+            int slot = bookMgr.prepareBuy(isbn, quantity, after, totalCost);
+            if (slot < 0) return false;
+            
+            if (!txnMgr.commit(slot, after, totalCost, true, bookMgr, logMgr)) return false;
+            out << fixed << setprecision(2) << totalCost << "\n";
+            return true;
+        }
+        else if (cmd == "select") {
+            if (accountMgr.getCurrentPrivilege() < 3) return false;
+            if (tokens.size() != 2) return false;
+            string isbn = tokens[1];
+            if (!isValidISBN(isbn)) return false;
+            accountMgr.setSelectedBook(isbn, bookMgr.selectBook(isbn));
+            return true;
+        }
+        else if (cmd == "modify") {
+            if (accountMgr.getCurrentPrivilege() < 3) return false;
+            string isbn = accountMgr.getSelectedBook();
+            if (isbn.empty()) return false;
+            
+            string newISBN, name, author, keyword;
+            double price = -1;
+            set<string> usedParams;
+            
+            for (size_t i = 1; i < tokens.size(); i++) {
+                string param = tokens[i];
+                string paramType;
+                
+                if (param.substr(0, 6) == "-ISBN=") {
+                    paramType = "ISBN";
+                    newISBN = param.substr(6);
+                    if (!isValidISBN(newISBN)) return false;
+                } else if (param.substr(0, 6) == "-name=") {
+                    paramType = "name";
+                    name = extractQuoted(param);
+                    if (!isValidBookString(name)) return false;
+                } else if (param.substr(0, 8) == "-author=") {
+                    paramType = "author";
+                    author = extractQuoted(param);
+                    if (!isValidBookString(author)) return false;
+                } else if (param.substr(0, 9) == "-keyword=") {
+                    paramType = "keyword";
+                    keyword = extractQuoted(param);
+                    if (keyword.empty() || !isValidKeyword(keyword)) return false;
+                } else if (param.substr(0, 7) == "-price=") {
+                    paramType = "price";
+                    string priceStr = param.substr(7);
+                    if (!isValidPrice(priceStr)) return false;
+                    if (!safeStod(priceStr, price)) return false;
+                    if (price < 0) return false;
+                } else {
+                    return false;
+                }
+                
+                if (usedParams.count(paramType)) return false;
+                usedParams.insert(paramType);
+            }
+            
+            if (usedParams.empty()) return false;
+            
+            RecordHandle handle = accountMgr.getSelectedHandle();
+            Book after;
+            int slot = bookMgr.prepareModify(isbn, handle, newISBN, name, author, keyword, price, after);
+            bool modified = slot >= 0;
+            if (modified) {
+                int target = bookMgr.targetSlot(slot, after);
+                if (target == slot) {
+                    handle = bookMgr.applyModify(slot, isbn, after);
+                } else {
+                    modified = txnMgr.commitMove(slot, isbn, target, after, bookMgr, logMgr);
+                    if (modified) handle = bookMgr.handleOf(target);
+                }
+            }
+            accountMgr.setSelectedBook(modified && !newISBN.empty() ? newISBN : isbn, handle);
+            return modified;
+        }
+        else if (cmd == "import") {
+            if (accountMgr.getCurrentPrivilege() < 3) return false;
+            string isbn = accountMgr.getSelectedBook();
+            if (isbn.empty()) return false;
+            if (tokens.size() != 3) return false;
+            
+            if (!isValidInteger(tokens[1])) return false;
+            if (!isValidPrice(tokens[2])) return false;
+            int quantity;
+            double totalCost;
+            if (!safeStoi(tokens[1], quantity)) return false;
+            if (!safeStod(tokens[2], totalCost)) return false;
+            if (quantity <= 0 || totalCost <= 0) return false;
+            
+            Book after;
+            RecordHandle handle = accountMgr.getSelectedHandle();
+            int slot = bookMgr.prepareImport(isbn, handle, quantity, after);
+            accountMgr.setSelectedBook(isbn, handle);
+            if (slot < 0) return false;
+            
+            if (!txnMgr.commit(slot, after, totalCost, false, bookMgr, logMgr)) return false;
+            return true;
+        }
+        else if (cmd == "log") {
+            if (accountMgr.getCurrentPrivilege() < 7) return false;
+            out << logMgr.generateLog();
+            out << generateStorageReport();
+            return true;
+        }
+        else if (cmd == "report") {
+            if (accountMgr.getCurrentPrivilege() < 7) return false;
+            if (tokens.size() != 2) return false;
+            
+            if (tokens[1] == "finance") {
+                out << logMgr.generateFinanceReport();
+            } else if (tokens[1] == "employee") {
+                out << logMgr.generateEmployeeReport();
+            } else {
+                return false;
+            }
+            return true;
+        }
+        
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef BOOKSTORE_STRING_MATCH_H
+#define BOOKSTORE_STRING_MATCH_H
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BOOKSTORE_HAS_X86_KERNELS 1
+#endif
+
+// ==================== String Match Kernels ====================
+//
+// Predicates for the fixed-size char fields of a record. A field must have at
+// least MATCH_WIDTH readable bytes; only the bytes up to the query's
+// terminator are compared, so whatever follows a field's terminator is
+// ignored and strcmp semantics are kept.
+
+const size_t MATCH_WIDTH = 64;
+
+// Query string copied once into a zero-padded block the kernels can load.
+struct PaddedKey {
+    alignas(32) char bytes[MATCH_WIDTH];
+    std::string text;
+
+    explicit PaddedKey(const std::string& value) : text(value) {
+        memset(bytes, 0, sizeof(bytes));
+        memcpy(bytes, value.c_str(), std::min(value.size(), MATCH_WIDTH - 1));
+    }
+
+    // Queries that do not fit the block take the scalar path
+    bool fits() const {
+        return text.size() < MATCH_WIDTH;
+    }
+};
+
+struct MatchKernels {
+    const char* name;
+    // strcmp(field, key) == 0
+    bool (*fieldEquals)(const char* field, const PaddedKey& key);
+    // key (non-empty) is one of the '|'-separated segments of list
+    bool (*keywordListContains)(const char* list, const PaddedKey& key);
+};
+
+inline bool scalarFieldEquals(const char* field, const PaddedKey& key) {
+    return strcmp(field, key.text.c_str()) == 0;
+}
+
+inline bool scalarKeywordListContains(const char* list, const PaddedKey& key) {
+    size_t length = key.text.size();
+    const char* segment = list;
+    while (true) {
+        const char* end = segment;
+        while (*end != '\0' && *end != '|') end++;
+        if ((size_t)(end - segment) == length && memcmp(segment, key.text.c_str(), length) == 0) {
+            return true;
+        }
+        if (*end == '\0') return false;
+        segment = end + 1;
+    }
+}
+
+// Walks the segments of list whose end positions are the set bits of
+// `delimiters` (every '|' before the terminator, and the terminator itself).
+inline bool segmentsContain(const char* list, uint64_t delimiters, const PaddedKey& key) {
+    size_t length = key.text.size();
+    size_t start = 0;
+    while (delimiters) {
+        size_t end = __builtin_ctzll(delimiters);
+        if (end - start == length && memcmp(list + start, key.bytes, length) == 0) return true;
+        start = end + 1;
+        delimiters &= delimiters - 1;
+    }
+    return false;
+}
+
+#ifdef BOOKSTORE_HAS_X86_KERNELS
+
+__attribute__((target("sse2")))
+inline bool sse2FieldEquals(const char* field, const PaddedKey& key) {
+    if (!key.fits()) return scalarFieldEquals(field, key);
+    size_t span = key.text.size() + 1;
+    for (size_t offset = 0; offset < span; offset += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field + offset));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(key.bytes + offset));
+        unsigned mismatch = ~_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xFFFFu;
+        if (span - offset < 16) mismatch &= (1u << (span - offset)) - 1;
+        if (mismatch) return false;
+    }
+    return true;
+}
+
+__attribute__((target("sse2")))
+inline bool sse2KeywordListContains(const char* list, const PaddedKey& key) {
+    if (!key.fits()) return scalarKeywordListContains(list, key);
+    uint64_t pipes = 0, nuls = 0;
+    __m128i pipe = _mm_set1_epi8('|'), zero = _mm_setzero_si128();
+    for (size_t offset = 0; offset < MATCH_WIDTH; offset += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(list + offset));
+        pipes |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, pipe)) << offset;
+        nuls |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)) << offset;
+    }
+    if (!nuls) return scalarKeywordListContains(list, key);
+    uint64_t terminator = nuls & -nuls;
+    return segmentsContain(list, (pipes & (terminator - 1)) | terminator, key);
+}
+
+__attribute__((target("avx2")))
+inline bool avx2FieldEquals(const char* field, const PaddedKey& key) {
+    if (!key.fits()) return scalarFieldEquals(field, key);
+    size_t span = key.text.size() + 1;
+    for (size_t offset = 0; offset < span; offset += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(field + offset));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(key.bytes + offset));
+        uint32_t mismatch = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+        if (span - offset < 32) mismatch &= (1u << (span - offset)) - 1;
+        if (mismatch) return false;
+    }
+    return true;
+}
+
+__attribute__((target("avx2")))
+inline bool avx2KeywordListContains(const char* list, const PaddedKey& key) {
+    if (!key.fits()) return scalarKeywordListContains(list, key);
+    __m256i pipe = _mm256_set1_epi8('|'), zero = _mm256_setzero_si256();
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(list));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(list + 32));
+    uint64_t pipes = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, pipe))
+                   | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, pipe)) << 32;
+    uint64_t nuls = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, zero))
+                  | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, zero)) << 32;
+    if (!nuls) return scalarKeywordListContains(list, key);
+    uint64_t terminator = nuls & -nuls;
+    return segmentsContain(list, (pipes & (terminator - 1)) | terminator, key);
+}
+
+#endif
+
+inline const MatchKernels& scalarKernels() {
+    static const MatchKernels kernels = {"scalar", scalarFieldEquals, scalarKeywordListContains};
+    return kernels;
+}
+
+#ifdef BOOKSTORE_HAS_X86_KERNELS
+inline const MatchKernels& sse2Kernels() {
+    static const MatchKernels kernels = {"sse2", sse2FieldEquals, sse2KeywordListContains};
+    return kernels;
+}
+
+inline const MatchKernels& avx2Kernels() {
+    static const MatchKernels kernels = {"avx2", avx2FieldEquals, avx2KeywordListContains};
+    return kernels;
+}
+#endif
+
+// Best kernels the running CPU supports, chosen on first use
+inline const MatchKernels& matchKernels() {
+#ifdef BOOKSTORE_HAS_X86_KERNELS
+    static const MatchKernels& selected =
+        __builtin_cpu_supports("avx2") ? avx2Kernels() :
+        __builtin_cpu_supports("sse2") ? sse2Kernels() : scalarKernels();
+    return selected;
+#else
+    return scalarKernels();
+#endif
+}
+
+#endif
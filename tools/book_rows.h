@@ -0,0 +1,156 @@
+#ifndef BOOKSTORE_BOOK_ROWS_H
+#define BOOKSTORE_BOOK_ROWS_H
+
+// Text rows for bookstore_export and bookstore_import. A row holds the
+// columns of a `show` line: ISBN, name, author, keyword, price and quantity.
+// Prices have two decimals like `show` unless the stored value needs more
+// (-price=3.333), so a row reloads to the same book; TSV rows are otherwise
+// byte-for-byte `show` lines. CSV rows quote fields as RFC 4180 does. TSV
+// cannot carry a field holding a tab; use CSV for such stores.
+
+#include "../bookstore.h"
+
+enum class RowFormat { TSV, CSV };
+
+inline bool parseRowFormat(const string& name, RowFormat& format) {
+    if (name == "tsv") format = RowFormat::TSV;
+    else if (name == "csv") format = RowFormat::CSV;
+    else return false;
+    return true;
+}
+
+inline void writeCsvField(ostream& out, const char* field) {
+    if (strpbrk(field, ",\"\r\n") == nullptr) {
+        out << field;
+        return;
+    }
+    out << '"';
+    for (const char* c = field; *c; c++) {
+        if (*c == '"') out << '"';
+        out << *c;
+    }
+    out << '"';
+}
+
+// Shortest fixed-point text, from two decimals up, that reads back as `price`
+inline string formatPrice(double price) {
+    string text;
+    for (int decimals = 2; decimals <= 40; decimals++) {
+        stringstream ss;
+        ss << fixed << setprecision(decimals) << price;
+        text = ss.str();
+        if (stod(text) == price) break;
+    }
+    return text;
+}
+
+inline void writeBookRow(ostream& out, const Book& book, RowFormat format) {
+    if (format == RowFormat::TSV) {
+        out << book.ISBN << "\t" << book.name << "\t" << book.author << "\t" << book.keyword
+            << "\t" << formatPrice(book.price) << "\t" << book.quantity << "\n";
+        return;
+    }
+    writeCsvField(out, book.ISBN);
+    out << ',';
+    writeCsvField(out, book.name);
+    out << ',';
+    writeCsvField(out, book.author);
+    out << ',';
+    writeCsvField(out, book.keyword);
+    out << ',' << formatPrice(book.price) << ',' << book.quantity << "\n";
+}
+
+// Splits one line into fields; returns false on a malformed quoted field.
+// Quoted CSV fields may not span lines: no valid book field holds a newline.
+inline bool splitRow(const string& line, RowFormat format, vector<string>& fields) {
+    fields.clear();
+    if (format == RowFormat::TSV) {
+        stringstream ss(line);
+        string field;
+        while (getline(ss, field, '\t')) fields.push_back(field);
+        if (!line.empty() && line.back() == '\t') fields.push_back("");
+        return true;
+    }
+
+    string field;
+    size_t i = 0;
+    while (true) {
+        field.clear();
+        if (i < line.size() && line[i] == '"') {
+            i++;
+            while (true) {
+                if (i >= line.size()) return false;
+                if (line[i] == '"') {
+                    if (i + 1 < line.size() && line[i + 1] == '"') {
+                        field += '"';
+                        i += 2;
+                    } else {
+                        i++;
+                        break;
+                    }
+                } else {
+                    field += line[i++];
+                }
+            }
+            if (i < line.size() && line[i] != ',') return false;
+        } else {
+            while (i < line.size() && line[i] != ',') field += line[i++];
+        }
+        fields.push_back(field);
+        if (i >= line.size()) return true;
+        i++; // the comma
+    }
+}
+
+// Checks a row with the engine's own field validators (isValidISBN and the
+// rest) and fills `book`. Name, author and keyword may also be empty, as for
+// a book that was selected but never modified.
+inline bool parseBookRow(const vector<string>& fields, Book& book, string& error) {
+    if (fields.size() != 6) {
+        error = "expected 6 fields, found " + to_string(fields.size());
+        return false;
+    }
+    if (!isValidISBN(fields[0])) {
+        error = "ISBN must be 1 to 20 characters";
+        return false;
+    }
+    for (int i = 1; i <= 2; i++) {
+        if (!fields[i].empty() && !isValidBookString(fields[i])) {
+            error = "field " + to_string(i + 1) + " is longer than 60 characters";
+            return false;
+        }
+    }
+    if (!fields[3].empty() && !isValidKeyword(fields[3])) {
+        error = "keyword is too long or has an empty or repeated segment";
+        return false;
+    }
+    double price;
+    if (!isValidPrice(fields[4]) || !safeStod(fields[4], price)) {
+        error = "price is not a decimal number";
+        return false;
+    }
+    int quantity;
+    if (!isValidInteger(fields[5]) || !safeStoi(fields[5], quantity)) {
+        error = "quantity is not a non-negative integer";
+        return false;
+    }
+
+    book = Book();
+    strcpy(book.ISBN, fields[0].c_str());
+    strcpy(book.name, fields[1].c_str());
+    strcpy(book.author, fields[2].c_str());
+    strcpy(book.keyword, fields[3].c_str());
+    book.price = price;
+    book.quantity = quantity;
+    return true;
+}
+
+// Applies a buy, import or cross-shard rename left in journal.dat by a
+// process that died, so the tools see the same books a restarted `code` would
+inline void recoverPendingCommit(const StorageConfig& config) {
+    if (FileStorage(config.filePath("journal.dat")).size() == 0) return;
+    ostream discard(nullptr);
+    BookstoreSystem system(config, discard);
+}
+
+#endif
@@ -0,0 +1,477 @@
+#ifndef BOOKSTORE_REFERENCE_MODEL_H
+#define BOOKSTORE_REFERENCE_MODEL_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+// ==================== Reference Model ====================
+//
+// In-memory oracle for bookstore_replay. It keeps the command semantics of
+// the original load-all/save-all BookstoreSystem, including its parsing and
+// every Invalid path, with plain std::string fields and no files. Storage
+// engine changes must not change what this model prints or stores; only
+// change it together with a deliberate change to the command semantics.
+
+struct ReferenceAccount {
+    string password;
+    string username;
+    int privilege;
+};
+
+struct ReferenceBook {
+    string name;
+    string author;
+    string keyword;
+    double price = 0;
+    int quantity = 0;
+};
+
+struct ReferenceTransaction {
+    double amount;
+    bool isIncome;
+};
+
+struct ReferenceLogEntry {
+    string userID;
+    string operation;
+};
+
+class ReferenceBookstore {
+public:
+    map<string, ReferenceAccount> accounts;
+    map<string, ReferenceBook> books;
+    vector<ReferenceTransaction> transactions;
+    vector<ReferenceLogEntry> logs;
+
+private:
+    vector<pair<string, string>> loginStack; // (userID, selectedISBN)
+    ostream& out;
+    bool quitRequested;
+
+    int currentPrivilege() {
+        if (loginStack.empty()) return 0;
+        return accounts[loginStack.back().first].privilege;
+    }
+
+    string selectedBook() {
+        if (loginStack.empty()) return "";
+        return loginStack.back().second;
+    }
+
+    void printBook(const string& isbn, const ReferenceBook& book) {
+        out << isbn << "\t" << book.name << "\t" << book.author << "\t" << book.keyword
+            << "\t" << fixed << setprecision(2) << book.price << "\t" << book.quantity << "\n";
+    }
+
+    bool matchKeyword(const string& keywords, const string& keyword) {
+        stringstream ss(keywords);
+        string k;
+        while (getline(ss, k, '|')) {
+            if (k == keyword) return true;
+        }
+        return false;
+    }
+
+    vector<string> tokenize(const string& line) {
+        vector<string> tokens;
+        string token;
+        bool inQuote = false;
+        for (char c : line) {
+            if (c == '"') {
+                token += c;
+                inQuote = !inQuote;
+            } else if (c == ' ' && !inQuote) {
+                if (!token.empty()) {
+                    tokens.push_back(token);
+                    token.clear();
+                }
+            } else {
+                token += c;
+            }
+        }
+        if (!token.empty()) tokens.push_back(token);
+        return tokens;
+    }
+
+    string extractQuoted(const string& str) {
+        size_t start = str.find('"');
+        size_t end = str.rfind('"');
+        if (start != string::npos && end != string::npos && start < end) {
+            return str.substr(start + 1, end - start - 1);
+        }
+        return "";
+    }
+
+    bool isValidUserID(const string& str) {
+        if (str.empty() || str.length() > 30) return false;
+        for (char c : str) {
+            if (!isalnum(c) && c != '_') return false;
+        }
+        return true;
+    }
+
+    bool isValidISBN(const string& str) {
+        return !str.empty() && str.length() <= 20;
+    }
+
+    bool isValidBookString(const string& str) {
+        return !str.empty() && str.length() <= 60;
+    }
+
+    bool isValidKeyword(const string& str) {
+        if (str.empty() || str.length() > 60) return false;
+        set<string> keywords;
+        stringstream ss(str);
+        string k;
+        while (getline(ss, k, '|')) {
+            if (k.empty() || keywords.count(k)) return false;
+            keywords.insert(k);
+        }
+        return true;
+    }
+
+    bool safeStoi(const string& str, int& result) {
+        if (str.empty()) return false;
+        try {
+            size_t pos;
+            result = stoi(str, &pos);
+            return pos == str.length();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    bool safeStod(const string& str, double& result) {
+        if (str.empty()) return false;
+        try {
+            size_t pos;
+            result = stod(str, &pos);
+            return pos == str.length();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    bool isValidPrice(const string& str) {
+        if (str.empty()) return false;
+        int dotCount = 0;
+        for (char c : str) {
+            if (c == '.') {
+                if (++dotCount > 1) return false;
+            } else if (!isdigit(c)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isValidInteger(const string& str) {
+        if (str.empty()) return false;
+        for (char c : str) {
+            if (!isdigit(c)) return false;
+        }
+        return true;
+    }
+
+    bool show(const vector<string>& tokens) {
+        if (currentPrivilege() < 1) return false;
+
+        if (tokens.size() == 1) {
+            if (books.empty()) out << "\n";
+            for (const auto& pair : books) printBook(pair.first, pair.second);
+            return true;
+        }
+
+        if (tokens[1] == "finance") {
+            if (currentPrivilege() < 7) return false;
+            int count = -1;
+            if (tokens.size() == 3) {
+                if (!isValidInteger(tokens[2]) || !safeStoi(tokens[2], count)) return false;
+            }
+            if (count == 0) {
+                out << "\n";
+                return true;
+            }
+            if (count > 0 && count > (int)transactions.size()) return false;
+            size_t start = count > 0 ? transactions.size() - count : 0;
+            double income = 0, expenditure = 0;
+            for (size_t i = start; i < transactions.size(); i++) {
+                if (transactions[i].isIncome) income += transactions[i].amount;
+                else expenditure += transactions[i].amount;
+            }
+            out << "+ " << fixed << setprecision(2) << income << " - " << expenditure << "\n";
+            return true;
+        }
+
+        const string& param = tokens[1];
+        string type, value;
+        if (param.substr(0, 6) == "-ISBN=") {
+            type = "ISBN";
+            value = param.substr(6);
+            if (!isValidISBN(value)) return false;
+        } else if (param.substr(0, 6) == "-name=") {
+            type = "name";
+            value = extractQuoted(param);
+            if (!isValidBookString(value)) return false;
+        } else if (param.substr(0, 8) == "-author=") {
+            type = "author";
+            value = extractQuoted(param);
+            if (!isValidBookString(value)) return false;
+        } else if (param.substr(0, 9) == "-keyword=") {
+            type = "keyword";
+            value = extractQuoted(param);
+            if (value.empty() || value.find('|') != string::npos) return false;
+        } else {
+            return false;
+        }
+
+        bool any = false;
+        for (const auto& pair : books) {
+            const ReferenceBook& book = pair.second;
+            bool match = (type == "ISBN" && pair.first == value) ||
+                         (type == "name" && book.name == value) ||
+                         (type == "author" && book.author == value) ||
+                         (type == "keyword" && matchKeyword(book.keyword, value));
+            if (match) {
+                printBook(pair.first, book);
+                any = true;
+            }
+        }
+        if (!any) out << "\n";
+        return true;
+    }
+
+    bool modify(const vector<string>& tokens) {
+        if (currentPrivilege() < 3) return false;
+        string isbn = selectedBook();
+        if (isbn.empty()) return false;
+
+        string newISBN, name, author, keyword;
+        double price = -1;
+        set<string> usedParams;
+        for (size_t i = 1; i < tokens.size(); i++) {
+            const string& param = tokens[i];
+            string paramType;
+            if (param.substr(0, 6) == "-ISBN=") {
+                paramType = "ISBN";
+                newISBN = param.substr(6);
+                if (!isValidISBN(newISBN)) return false;
+            } else if (param.substr(0, 6) == "-name=") {
+                paramType = "name";
+                name = extractQuoted(param);
+                if (!isValidBookString(name)) return false;
+            } else if (param.substr(0, 8) == "-author=") {
+                paramType = "author";
+                author = extractQuoted(param);
+                if (!isValidBookString(author)) return false;
+            } else if (param.substr(0, 9) == "-keyword=") {
+                paramType = "keyword";
+                keyword = extractQuoted(param);
+                if (keyword.empty() || !isValidKeyword(keyword)) return false;
+            } else if (param.substr(0, 7) == "-price=") {
+                paramType = "price";
+                string priceStr = param.substr(7);
+                if (!isValidPrice(priceStr) || !safeStod(priceStr, price) || price < 0) return false;
+            } else {
+                return false;
+            }
+            if (usedParams.count(paramType)) return false;
+            usedParams.insert(paramType);
+        }
+        if (usedParams.empty()) return false;
+
+        if (!books.count(isbn)) return false;
+        if (!newISBN.empty()) {
+            if (newISBN == isbn || books.count(newISBN)) return false;
+            books[newISBN] = books[isbn];
+            books.erase(isbn);
+            loginStack.back().second = newISBN;
+        }
+        ReferenceBook& book = books[newISBN.empty() ? isbn : newISBN];
+        if (!name.empty()) book.name = name;
+        if (!author.empty()) book.author = author;
+        if (!keyword.empty()) book.keyword = keyword;
+        if (price >= 0) book.price = price;
+        return true;
+    }
+
+    bool processCommand(const string& line) {
+        vector<string> tokens = tokenize(line);
+        if (tokens.empty()) return true;
+        const string& cmd = tokens[0];
+
+        if (currentPrivilege() > 0) {
+            logs.push_back({loginStack.back().first, line});
+        }
+
+        if (cmd == "quit" || cmd == "exit") {
+            quitRequested = true;
+            return true;
+        }
+        if (cmd == "su") {
+            if (tokens.size() < 2 || tokens.size() > 3) return false;
+            string password = tokens.size() == 3 ? tokens[2] : "";
+            if (!isValidUserID(tokens[1]) || !accounts.count(tokens[1])) return false;
+            const ReferenceAccount& acc = accounts[tokens[1]];
+            if (!password.empty() && password != acc.password && currentPrivilege() <= acc.privilege) {
+                return false;
+            }
+            loginStack.push_back({tokens[1], ""});
+            return true;
+        }
+        if (cmd == "logout") {
+            if (currentPrivilege() < 1) return false;
+            loginStack.pop_back();
+            return true;
+        }
+        if (cmd == "register") {
+            if (tokens.size() != 4) return false;
+            if (!isValidUserID(tokens[1]) || !isValidUserID(tokens[2])) return false;
+            if (accounts.count(tokens[1])) return false;
+            accounts[tokens[1]] = {tokens[2], tokens[3], 1};
+            return true;
+        }
+        if (cmd == "passwd") {
+            if (currentPrivilege() < 1) return false;
+            if (tokens.size() < 3 || tokens.size() > 4) return false;
+            string currentPassword = tokens.size() == 4 ? tokens[2] : "";
+            string newPassword = tokens.size() == 4 ? tokens[3] : tokens[2];
+            if (!isValidUserID(tokens[1]) || !isValidUserID(newPassword)) return false;
+            if (tokens.size() == 4 && !isValidUserID(currentPassword)) return false;
+            if (!accounts.count(tokens[1])) return false;
+            ReferenceAccount& acc = accounts[tokens[1]];
+            if (!currentPassword.empty() ? currentPassword != acc.password : currentPrivilege() != 7) {
+                return false;
+            }
+            acc.password = newPassword;
+            return true;
+        }
+        if (cmd == "useradd") {
+            if (currentPrivilege() < 3) return false;
+            if (tokens.size() != 5) return false;
+            int privilege;
+            if (!isValidInteger(tokens[3]) || !safeStoi(tokens[3], privilege)) return false;
+            if (!isValidUserID(tokens[1]) || !isValidUserID(tokens[2])) return false;
+            if (privilege != 1 && privilege != 3 && privilege != 7) return false;
+            if (accounts.count(tokens[1]) || privilege >= currentPrivilege()) return false;
+            accounts[tokens[1]] = {tokens[2], tokens[4], privilege};
+            return true;
+        }
+        if (cmd == "delete") {
+            if (currentPrivilege() < 7) return false;
+            if (tokens.size() != 2 || !accounts.count(tokens[1])) return false;
+            for (const auto& login : loginStack) {
+                if (login.first == tokens[1]) return false;
+            }
+            accounts.erase(tokens[1]);
+            return true;
+        }
+        if (cmd == "show") {
+            return show(tokens);
+        }
+        if (cmd == "buy") {
+            if (currentPrivilege() < 1) return false;
+            if (tokens.size() != 3 || !isValidISBN(tokens[1])) return false;
+            int quantity;
+            if (!isValidInteger(tokens[2]) || !safeStoi(tokens[2], quantity) || quantity <= 0) return false;
+            auto it = books.find(tokens[1]);
+            if (it == books.end() || it->second.quantity < quantity) return false;
+            double totalCost = it->second.price * quantity;
+            it->second.quantity -= quantity;
+            transactions.push_back({totalCost, true});
+            out << fixed << setprecision(2) << totalCost << "\n";
+            return true;
+        }
+        if (cmd == "select") {
+            if (currentPrivilege() < 3) return false;
+            if (tokens.size() != 2 || !isValidISBN(tokens[1])) return false;
+            books[tokens[1]];
+            loginStack.back().second = tokens[1];
+            return true;
+        }
+        if (cmd == "modify") {
+            return modify(tokens);
+        }
+        if (cmd == "import") {
+            if (currentPrivilege() < 3) return false;
+            string isbn = selectedBook();
+            if (isbn.empty() || tokens.size() != 3) return false;
+            if (!isValidInteger(tokens[1]) || !isValidPrice(tokens[2])) return false;
+            int quantity;
+            double totalCost;
+            if (!safeStoi(tokens[1], quantity) || !safeStod(tokens[2], totalCost)) return false;
+            if (quantity <= 0 || totalCost <= 0) return false;
+            if (!books.count(isbn)) return false;
+            books[isbn].quantity += quantity;
+            transactions.push_back({totalCost, false});
+            return true;
+        }
+        if (cmd == "log") {
+            if (currentPrivilege() < 7) return false;
+            out << "=== System Log ===\n";
+            out << "Total Log Entries: " << logs.size() << "\n";
+            for (const auto& log : logs) {
+                out << "[" << log.userID << "] " << log.operation << "\n";
+            }
+            return true;
+        }
+        if (cmd == "report") {
+            if (currentPrivilege() < 7) return false;
+            if (tokens.size() != 2) return false;
+            if (tokens[1] == "finance") {
+                double income = 0, expenditure = 0;
+                for (const auto& t : transactions) {
+                    if (t.isIncome) income += t.amount;
+                    else expenditure += t.amount;
+                }
+                out << "=== Finance Report ===\n";
+                out << "Total Transactions: " << transactions.size() << "\n";
+                out << fixed << setprecision(2);
+                out << "Total Income: " << income << "\n";
+                out << "Total Expenditure: " << expenditure << "\n";
+                out << "Net Profit: " << (income - expenditure) << "\n";
+            } else if (tokens[1] == "employee") {
+                map<string, int> userOps;
+                for (const auto& log : logs) userOps[log.userID]++;
+                out << "=== Employee Report ===\n";
+                for (const auto& pair : userOps) {
+                    out << "User: " << pair.first << ", Operations: " << pair.second << "\n";
+                }
+            } else {
+                return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit ReferenceBookstore(ostream& out) : out(out), quitRequested(false) {
+        accounts["root"] = {"sjtu", "root", 7};
+    }
+
+    // Same contract as BookstoreSystem::execute
+    bool execute(string line) {
+        size_t start = line.find_first_not_of(" \t\r\n");
+        size_t end = line.find_last_not_of(" \t\r\n");
+        if (start == string::npos) return true;
+        line = line.substr(start, end - start + 1);
+        if (!processCommand(line)) out << "Invalid\n";
+        return !quitRequested;
+    }
+
+    // A new process starts with an empty login stack and nothing selected
+    void restart() {
+        loginStack.clear();
+        quitRequested = false;
+    }
+};
+
+#endif
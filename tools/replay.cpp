@@ -0,0 +1,522 @@
+// bookstore_replay: differential tester for the storage engine.
+//
+// Replays command traces against BookstoreSystem and the in-memory
+// ReferenceBookstore, compares the output of every command and, at each
+// restart and at the end of a trace, the persisted files against the model.
+//
+// Usage:
+//   bookstore_replay [--seed N] [--traces N] [--length N] [--large N] [--verbose]
+//                    [storage options] [trace...]
+//
+// Trace files hold one command per line. Three directives simulate process
+// boundaries:
+//   #restart   the process exits normally and a new one opens the same files
+//   #crash     the process dies before its between-command maintenance runs
+//   #fault N   the next command runs in a forked process that dies just
+//              before its N-th data file write (counting the maintenance
+//              after it). The files, once reopened, must hold the state from
+//              before or after that command; the command's own log entry,
+//              written first, may be present either way.
+// Faults end the process between whole record writes; torn records are not
+// simulated.
+//
+// Without trace files, --traces random traces are generated from --seed.
+// --large N writes N books (through RecordStore::bulkLoad), N transactions
+// and N log entries into the files and the model before each trace, so the
+// parallel show and log paths run (they start at PARALLEL_SCAN_MIN_RECORDS).
+// Storage options (--book-shards, --ledger-shards, --page-size, ...) are
+// passed to the engine as for `code`; the data directory is always a fresh
+// temporary one. Book shards above one exercise cross-shard renames.
+
+#include "../bookstore.h"
+#include "reference_model.h"
+#include <chrono>
+#include <random>
+#include <memory>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace fs = std::filesystem;
+
+struct TraceResult {
+    bool ok;
+    string failure;
+    size_t commands;
+    double engineMillis;
+    double referenceMillis;
+};
+
+class Stopwatch {
+private:
+    chrono::steady_clock::time_point start;
+    double& total;
+
+public:
+    explicit Stopwatch(double& total) : start(chrono::steady_clock::now()), total(total) {}
+
+    ~Stopwatch() {
+        total += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+// ==================== Trace Generation ====================
+
+class TraceGenerator {
+private:
+    mt19937 rng;
+    vector<string> users = {"root", "root", "alice", "bob", "carol", "dave_1", "bad-id"};
+    vector<string> passwords = {"sjtu", "pw", "pw2", "wrong"};
+    vector<string> isbns = {"978-0", "978-1", "abc", "Z9", "q|w", "x\"y", "012345678901234567890"};
+    vector<string> words = {"math", "magic", "quantum", "art", "a b", "x", "", "|"};
+
+    int pick(int n) {
+        return rng() % n;
+    }
+
+    template<typename T>
+    const T& choose(const vector<T>& options) {
+        return options[pick(options.size())];
+    }
+
+    string keywordList() {
+        string result = choose(words);
+        int extra = pick(3);
+        for (int i = 0; i < extra; i++) result += "|" + choose(words);
+        return result;
+    }
+
+    string modifyCommand() {
+        vector<string> params = {
+            "-ISBN=" + choose(isbns),
+            "-name=\"" + choose(words) + "\"",
+            "-author=\"" + choose(words) + "\"",
+            "-keyword=\"" + keywordList() + "\"",
+            "-price=" + choose(vector<string>{"1.5", "10", "0.01", "3.333", "-1", "1.2.3"}),
+        };
+        shuffle(params.begin(), params.end(), rng);
+        string command = "modify";
+        int count = 1 + pick(3);
+        for (int i = 0; i < count; i++) command += " " + params[i];
+        if (pick(10) == 0) command += " " + params[0];
+        return command;
+    }
+
+    string showCommand() {
+        switch (pick(7)) {
+            case 0: return "show";
+            case 1: return "show -ISBN=" + choose(isbns);
+            case 2: return "show -name=\"" + choose(words) + "\"";
+            case 3: return "show -author=\"" + choose(words) + "\"";
+            case 4: return "show -keyword=\"" + choose(words) + "\"";
+            case 5: return "show -keyword=\"" + keywordList() + "\"";
+            default: return "show finance" + choose(vector<string>{"", " 0", " 1", " 3", " 100", " x"});
+        }
+    }
+
+    string command() {
+        int roll = pick(100);
+        if (roll < 12) return "su " + choose(users) + (pick(4) ? " " + choose(passwords) : "");
+        if (roll < 17) return "logout";
+        if (roll < 22) return "register " + choose(users) + " " + choose(passwords) + " name" + to_string(pick(9));
+        if (roll < 26) return "useradd " + choose(users) + " pw " + choose(vector<string>{"1", "3", "7", "0", "x"}) + " nm";
+        if (roll < 28) return "delete " + choose(users);
+        if (roll < 30) return "passwd " + choose(users) + " " + choose(passwords) + (pick(2) ? " " + choose(passwords) : "");
+        if (roll < 40) return "select " + choose(isbns);
+        if (roll < 53) return modifyCommand();
+        if (roll < 61) return "import " + to_string(pick(20)) + " " + choose(vector<string>{"10", "5.5", "0", "100.25", "1e3"});
+        if (roll < 71) return "buy " + choose(isbns) + " " + to_string(pick(6));
+        if (roll < 86) return showCommand();
+        if (roll < 90) return choose(vector<string>{"report finance", "report employee", "report x", "log"});
+        if (roll < 91) return choose(vector<string>{"quit", "exit", "   ", "unknown command"});
+        return "su root sjtu";
+    }
+
+public:
+    explicit TraceGenerator(unsigned seed) : rng(seed) {}
+
+    vector<string> generate(size_t length) {
+        vector<string> trace;
+        for (size_t i = 0; i < length; i++) {
+            int roll = pick(100);
+            if (roll < 2) trace.push_back("#restart");
+            else if (roll < 4) trace.push_back("#crash");
+            else if (roll < 7) trace.push_back("#fault " + to_string(1 + pick(6)));
+            else trace.push_back(command());
+        }
+        return trace;
+    }
+};
+
+// ==================== Fault Injection ====================
+
+// Exit status of a child process that reached its fault point
+const int FAULT_EXIT_STATUS = 75;
+
+long writesBeforeFault = 0;
+
+void countWriteTowardsFault() {
+    if (writesBeforeFault-- == 0) _exit(FAULT_EXIT_STATUS);
+}
+
+// Runs one command and its maintenance in a forked copy of the engine that
+// dies before its `fault`-th file write. Returns true if the fault was hit,
+// false if the command finished first.
+bool runUntilFault(BookstoreSystem& engine, const string& line, long fault) {
+    cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("bookstore_replay: fork");
+        exit(2);
+    }
+    if (pid == 0) {
+        writesBeforeFault = fault - 1;
+        beforeFileWrite = countWriteTowardsFault;
+        if (engine.execute(line)) engine.maintain();
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == FAULT_EXIT_STATUS;
+}
+
+// ==================== Replay ====================
+
+class Replayer {
+private:
+    StorageConfig config;
+    size_t largeRecords;
+    bool verbose;
+
+    static string formatPrice(double value) {
+        stringstream ss;
+        ss << fixed << setprecision(2) << value;
+        return ss.str();
+    }
+
+    // Compares the files left by the engine with the model's state
+    string diffPersistedState(const ReferenceBookstore& model) {
+        RecordStore<Account> accounts({config.filePath("accounts.dat")}, config.pageSize);
+        if (accounts.keys().size() != model.accounts.size()) {
+            return "accounts.dat holds " + to_string(accounts.keys().size()) + " accounts, expected " +
+                   to_string(model.accounts.size());
+        }
+        for (const auto& pair : model.accounts) {
+            int slot = accounts.find(pair.first);
+            if (slot < 0) return "account " + pair.first + " missing from accounts.dat";
+            const Account& acc = accounts.at(slot);
+            if (acc.password != pair.second.password || acc.username != pair.second.username ||
+                acc.privilege != pair.second.privilege) {
+                return "account " + pair.first + " differs in accounts.dat";
+            }
+        }
+
+        RecordStore<Book> books(config.shardPaths("books", config.bookShards), config.pageSize);
+        if (books.keys().size() != model.books.size()) {
+            return "books.dat holds " + to_string(books.keys().size()) + " books, expected " +
+                   to_string(model.books.size());
+        }
+        for (const auto& pair : model.books) {
+            int slot = books.find(pair.first);
+            if (slot < 0) return "book " + pair.first + " missing from books.dat";
+            const Book& book = books.at(slot);
+            const ReferenceBook& expected = pair.second;
+            if (book.name != expected.name || book.author != expected.author ||
+                book.keyword != expected.keyword || book.price != expected.price ||
+                book.quantity != expected.quantity) {
+                return "book " + pair.first + " differs in books.dat (quantity " + to_string(book.quantity) +
+                       ", price " + formatPrice(book.price) + ")";
+            }
+        }
+
+        LedgerFile<Transaction> transactionFile(config.shardPaths("transactions", config.ledgerShards),
+                                                config.pageSize);
+        vector<Transaction> transactions = transactionFile.readRange(0, transactionFile.size());
+        if (transactions.size() != model.transactions.size()) {
+            return "transactions.dat holds " + to_string(transactions.size()) + " records, expected " +
+                   to_string(model.transactions.size());
+        }
+        for (size_t i = 0; i < transactions.size(); i++) {
+            if (transactions[i].amount != model.transactions[i].amount ||
+                transactions[i].isIncome != model.transactions[i].isIncome) {
+                return "transaction " + to_string(i) + " differs in transactions.dat";
+            }
+        }
+
+        LedgerFile<LogEntry> logFile(config.shardPaths("logs", config.ledgerShards), config.pageSize);
+        vector<LogEntry> logs = logFile.readRange(0, logFile.size());
+        if (logs.size() != model.logs.size()) {
+            return "logs.dat holds " + to_string(logs.size()) + " records, expected " +
+                   to_string(model.logs.size());
+        }
+        for (size_t i = 0; i < logs.size(); i++) {
+            if (logs[i].userID != model.logs[i].userID || logs[i].operation != model.logs[i].operation) {
+                return "log entry " + to_string(i) + " differs in logs.dat";
+            }
+        }
+        return "";
+    }
+
+    // Writes the --large records straight into the files and the model
+    void seedStores(ReferenceBookstore& model) {
+        static const char* const words[] = {"math", "magic", "quantum", "art", "x"};
+        vector<Book> batch(largeRecords);
+        for (size_t i = 0; i < largeRecords; i++) {
+            Book& book = batch[i];
+            snprintf(book.ISBN, sizeof(book.ISBN), "S%07zu", i);
+            strcpy(book.name, words[i % 5]);
+            strcpy(book.author, words[i / 5 % 5]);
+            string keyword = words[i % 5];
+            if (i % 3) keyword += string("|") + words[(i + 1) % 5];
+            strcpy(book.keyword, keyword.c_str());
+            book.price = i % 100 + 0.25;
+            book.quantity = i % 7;
+            model.books[book.ISBN] = {book.name, book.author, book.keyword, book.price, book.quantity};
+        }
+        RecordStore<Book>(config.shardPaths("books", config.bookShards), config.pageSize).bulkLoad(batch);
+
+        LedgerFile<Transaction> transactions(config.shardPaths("transactions", config.ledgerShards),
+                                             config.pageSize);
+        LedgerFile<LogEntry> logs(config.shardPaths("logs", config.ledgerShards), config.pageSize);
+        for (size_t i = 0; i < largeRecords; i++) {
+            Transaction t;
+            t.amount = i % 50 + 0.5;
+            t.isIncome = i % 2;
+            transactions.write(i, t);
+            model.transactions.push_back({t.amount, t.isIncome});
+
+            LogEntry entry;
+            strcpy(entry.userID, "root");
+            strcpy(entry.operation, ("seed " + to_string(i)).c_str());
+            logs.write(i, entry);
+            model.logs.push_back({entry.userID, entry.operation});
+        }
+    }
+
+    static bool isDirective(const string& line) {
+        return line == "#restart" || line == "#crash";
+    }
+
+    // Returns N for a `#fault N` line, 0 for anything else
+    static long faultPoint(const string& line) {
+        if (line.compare(0, 7, "#fault ") != 0) return 0;
+        return max(1L, atol(line.c_str() + 7));
+    }
+
+    // `log` appends engine-specific storage details after the shared part
+    static string comparableOutput(const string& line, const string& output) {
+        stringstream ss(line);
+        string cmd;
+        ss >> cmd;
+        if (cmd != "log") return output;
+        size_t storage = output.rfind("=== Storage ===\n");
+        return storage == string::npos ? output : output.substr(0, storage);
+    }
+
+    // The state after a fault must be one the model could have reached
+    string diffAfterFault(unique_ptr<ReferenceBookstore>& model, unique_ptr<ReferenceBookstore>& before,
+                          bool faulted) {
+        string diff = diffPersistedState(*model);
+        if (diff.empty() || !faulted) return diff;
+        if (diffPersistedState(*before).empty()) {
+            model = move(before);
+            return "";
+        }
+        // The log entry is appended before the command runs
+        vector<ReferenceLogEntry> logs = model->logs;
+        ReferenceBookstore* logged = new ReferenceBookstore(*before);
+        logged->logs = logs;
+        before.reset(logged);
+        if (diffPersistedState(*before).empty()) {
+            model = move(before);
+            return "";
+        }
+        return diff;
+    }
+
+public:
+    Replayer(const StorageConfig& config, size_t largeRecords, bool verbose)
+        : config(config), largeRecords(largeRecords), verbose(verbose) {}
+
+    TraceResult replay(const vector<string>& trace) {
+        TraceResult result = {true, "", 0, 0, 0};
+        fs::remove_all(config.dataDir);
+        fs::create_directories(config.dataDir);
+
+        stringstream engineOut, modelOut;
+        unique_ptr<ReferenceBookstore> model(new ReferenceBookstore(modelOut));
+        if (largeRecords > 0) seedStores(*model);
+        unique_ptr<BookstoreSystem> engine;
+        {
+            Stopwatch timer(result.engineMillis);
+            engine.reset(new BookstoreSystem(config, engineOut));
+        }
+        bool running = true;
+        long fault = 0;
+
+        auto fail = [&](size_t line, const string& message) {
+            result.ok = false;
+            result.failure = "line " + to_string(line + 1) + ": " + message;
+        };
+
+        for (size_t i = 0; i < trace.size() && result.ok; i++) {
+            const string& line = trace[i];
+
+            if (isDirective(line)) {
+                engine.reset();
+                string diff = diffPersistedState(*model);
+                if (!diff.empty()) {
+                    fail(i, diff);
+                    break;
+                }
+                {
+                    Stopwatch timer(result.engineMillis);
+                    engine.reset(new BookstoreSystem(config, engineOut));
+                }
+                model->restart();
+                running = true;
+                continue;
+            }
+            if (faultPoint(line) > 0) {
+                fault = faultPoint(line);
+                continue;
+            }
+            if (!running) continue; // the process already quit
+
+            result.commands++;
+            if (fault > 0) {
+                unique_ptr<ReferenceBookstore> before(new ReferenceBookstore(*model));
+                model->execute(line);
+                bool faulted = runUntilFault(*engine, line, fault);
+                engine.reset();
+                {
+                    Stopwatch timer(result.engineMillis);
+                    engine.reset(new BookstoreSystem(config, engineOut));
+                }
+                string diff = diffAfterFault(model, before, faulted);
+                if (!diff.empty()) {
+                    fail(i, "after a fault at write " + to_string(fault) + " of \"" + line + "\": " + diff);
+                }
+                model->restart();
+                running = true;
+                fault = 0;
+                engineOut.str("");
+                modelOut.str("");
+                continue;
+            }
+
+            bool crashNext = i + 1 < trace.size() && trace[i + 1] == "#crash";
+            {
+                Stopwatch timer(result.engineMillis);
+                running = engine->execute(line);
+                if (running && !crashNext) engine->maintain();
+            }
+            {
+                Stopwatch timer(result.referenceMillis);
+                model->execute(line);
+            }
+
+            if (comparableOutput(line, engineOut.str()) != modelOut.str()) {
+                fail(i, "output differs for \"" + line + "\"\n  expected: " + modelOut.str() +
+                        "  actual:   " + engineOut.str());
+            } else if (verbose) {
+                cout << "  " << line << "\n" << engineOut.str();
+            }
+            engineOut.str("");
+            modelOut.str("");
+        }
+
+        if (result.ok) {
+            engine.reset();
+            string diff = diffPersistedState(*model);
+            if (!diff.empty()) fail(trace.size() - 1, "at end of trace: " + diff);
+        }
+
+        engine.reset();
+        fs::remove_all(config.dataDir);
+        return result;
+    }
+};
+
+vector<string> readTrace(const string& path, bool& ok) {
+    vector<string> trace;
+    ifstream file(path);
+    ok = bool(file);
+    string line;
+    while (getline(file, line)) trace.push_back(line);
+    return trace;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned seed = 1;
+    size_t traceCount = 100;
+    size_t traceLength = 400;
+    size_t largeRecords = 0;
+    bool verbose = false;
+    vector<string> files;
+    StorageConfig config;
+    string error;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (config.parseOption(argc, argv, i, error)) {
+            if (!error.empty()) {
+                cerr << "bookstore_replay: " << error << "\n";
+                return 2;
+            }
+        }
+        else if (arg == "--seed" && i + 1 < argc) seed = stoul(argv[++i]);
+        else if (arg == "--traces" && i + 1 < argc) traceCount = stoul(argv[++i]);
+        else if (arg == "--length" && i + 1 < argc) traceLength = stoul(argv[++i]);
+        else if (arg == "--large" && i + 1 < argc) largeRecords = stoul(argv[++i]);
+        else if (arg == "--verbose") verbose = true;
+        else if (!arg.empty() && arg[0] == '-') {
+            cerr << "usage: bookstore_replay [--seed N] [--traces N] [--length N] [--large N] [--verbose]"
+                 << " [storage options] [trace...]\n";
+            return 2;
+        }
+        else files.push_back(arg);
+    }
+
+    vector<pair<string, vector<string>>> traces;
+    for (const auto& file : files) {
+        bool ok;
+        traces.push_back({file, readTrace(file, ok)});
+        if (!ok) {
+            cerr << "cannot read trace " << file << "\n";
+            return 2;
+        }
+    }
+    if (files.empty()) {
+        for (size_t i = 0; i < traceCount; i++) {
+            TraceGenerator generator(seed + i);
+            traces.push_back({"seed " + to_string(seed + i), generator.generate(traceLength)});
+        }
+    }
+
+    random_device entropy;
+    config.dataDir = (fs::temp_directory_path() / ("bookstore_replay." + to_string(entropy()))).string();
+    if (!config.prepare(error)) {
+        cerr << "bookstore_replay: " << error << "\n";
+        return 2;
+    }
+    Replayer replayer(config, largeRecords, verbose);
+
+    size_t failures = 0;
+    double engineTotal = 0, referenceTotal = 0;
+    cout << fixed << setprecision(2);
+    for (const auto& trace : traces) {
+        TraceResult result = replayer.replay(trace.second);
+        engineTotal += result.engineMillis;
+        referenceTotal += result.referenceMillis;
+        cout << (result.ok ? "ok   " : "FAIL ") << trace.first << ": " << result.commands << " commands, engine "
+             << result.engineMillis << " ms, reference " << result.referenceMillis << " ms\n";
+        if (!result.ok) {
+            cout << "     " << result.failure << "\n";
+            failures++;
+        }
+    }
+
+    cout << traces.size() - failures << "/" << traces.size() << " traces passed, engine " << engineTotal
+         << " ms, reference " << referenceTotal << " ms\n";
+    return failures == 0 ? 0 : 1;
+}